@@ -0,0 +1,72 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <string>
+
+#include "../src/http/compressor.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+TEST(GTestHttpCompressor, TestNegotiate) {
+    ASSERT_EQ(Compressor::GZIP,
+        Compressor::negotiate(String::create("gzip, deflate, br")));
+    ASSERT_EQ(Compressor::DEFLATE,
+        Compressor::negotiate(String::create("deflate, gzip;q=0.5")));
+    ASSERT_EQ(Compressor::GZIP,
+        Compressor::negotiate(String::create("*")));
+    ASSERT_EQ(Compressor::NONE,
+        Compressor::negotiate(String::create("gzip;q=0, identity")));
+    ASSERT_EQ(Compressor::NONE,
+        Compressor::negotiate(String::create("br")));
+    ASSERT_EQ(Compressor::NONE,
+        Compressor::negotiate(String::null()));
+}
+
+TEST(GTestHttpCompressor, TestCompressible) {
+    ASSERT_TRUE(Compressor::compressible(
+        String::create("text/html; charset=utf-8")));
+    ASSERT_TRUE(Compressor::compressible(
+        String::create("application/json")));
+    ASSERT_TRUE(Compressor::compressible(
+        String::create("image/svg+xml")));
+    ASSERT_FALSE(Compressor::compressible(String::create("image/png")));
+    ASSERT_FALSE(Compressor::compressible(String::null()));
+}
+
+TEST(GTestHttpCompressor, TestDeflate) {
+    Compressor* compressor = Compressor::acquire(Compressor::GZIP, -1);
+    ASSERT_TRUE(compressor);
+
+    std::string in(100000, 'a');
+    std::string out;
+    ASSERT_TRUE(compressor->deflate(in.data(), 50000, Z_SYNC_FLUSH, &out));
+    ASSERT_TRUE(compressor->deflate(in.data(), 50000, Z_FINISH, &out));
+    ASSERT_GT(in.length(), out.length());
+
+    // reset and reused
+    Compressor::release(compressor);
+    ASSERT_EQ(compressor, Compressor::acquire(Compressor::GZIP, 6));
+    Compressor::release(compressor);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    ASSERT_EQ(Z_OK, inflateInit2(&stream, 15 + 16));
+    std::string inflated(in.length() + 1, 0);
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(out.data()));
+    stream.avail_in = out.length();
+    stream.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+    stream.avail_out = inflated.length();
+    ASSERT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    ASSERT_EQ(in.length(), stream.total_out);
+    inflateEnd(&stream);
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,156 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/http/header.h>
+#include <libnode/http/header_block.h>
+#include <string.h>
+
+#include <string>
+
+#include "../src/http/date_cache.h"
+#include "../src/http/header_buffer.h"
+#include "../src/http/incoming_message.h"
+#include "../src/http/known_header.h"
+#include "../src/http/status_line.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+TEST(GTestHttpHeader, TestKnownHeader) {
+    ASSERT_EQ(KNOWN_HEADER_HOST, knownHeader("Host", 4));
+    ASSERT_EQ(KNOWN_HEADER_HOST, knownHeader("hOST", 4));
+    ASSERT_EQ(KNOWN_HEADER_CONTENT_MD5, knownHeader("content-md5", 11));
+    ASSERT_EQ(KNOWN_HEADER_TE, knownHeader(String::create("te")));
+    ASSERT_EQ(KNOWN_HEADER_SEC_WEBSOCKET_VERSION,
+        knownHeader(String::create("SEC-WEBSOCKET-VERSION")));
+
+    ASSERT_EQ(KNOWN_HEADER_NONE, knownHeader("Hos", 3));
+    ASSERT_EQ(KNOWN_HEADER_NONE, knownHeader("Hosts", 5));
+    ASSERT_EQ(KNOWN_HEADER_NONE, knownHeader("X-Forwarded-For", 15));
+    ASSERT_EQ(KNOWN_HEADER_NONE, knownHeader("", 0));
+    ASSERT_EQ(KNOWN_HEADER_NONE, knownHeader(String::null()));
+}
+
+#define GTEST_HTTP_KNOWN_HEADER_GEN(NAME, VAL) \
+    ASSERT_EQ(KNOWN_##NAME, knownHeader(VAL, strlen(VAL))); \
+    ASSERT_EQ(KNOWN_##NAME, knownHeader(L##NAME)); \
+    ASSERT_TRUE(knownHeaderName(KNOWN_##NAME)->equals(L##NAME));
+
+TEST(GTestHttpHeader, TestKnownHeaderMap) {
+    LIBNODE_HTTP_HEADER_MAP(GTEST_HTTP_KNOWN_HEADER_GEN)
+}
+
+TEST(GTestHttpHeader, TestAddHeaderLine) {
+    IncomingMessage::Ptr msg = IncomingMessage::create(
+        net::SocketImpl::create(static_cast<uv::Stream*>(NULL), false));
+    msg->addHeaderLine(String::create("Accept"), String::create("a"));
+    msg->addHeaderLine(String::create("accept"), String::create("b"));
+    msg->addHeaderLine(String::create("Host"), String::create("x"));
+    msg->addHeaderLine(String::create("host"), String::create("y"));
+    msg->addHeaderLine(String::create("Set-Cookie"), String::create("c=1"));
+    msg->addHeaderLine(String::create("Set-Cookie"), String::create("d=2"));
+    msg->addHeaderLine(String::create("X-Foo"), String::create("1"));
+    msg->addHeaderLine(String::create("x-foo"), String::create("2"));
+    msg->addHeaderLine(String::create("Foo"), String::create("bar"));
+
+    ASSERT_TRUE(msg->getHeader(String::create("ACCEPT"))->equals(
+        String::create("a, b")));
+    ASSERT_TRUE(msg->getHeader(LHEADER_HOST)->equals(String::create("y")));
+    ASSERT_TRUE(msg->getHeader(String::create("x-foo"))->equals(
+        String::create("1, 2")));
+    ASSERT_TRUE(msg->getHeader(String::create("foo"))->equals(
+        String::create("bar")));
+    ASSERT_FALSE(msg->getHeader(LHEADER_DATE));
+
+    JsObject::CPtr headers = msg->headers();
+    ASSERT_EQ(5, headers->size());
+    ASSERT_TRUE(headers->getCPtr<String>(LHEADER_ACCEPT)->equals(
+        String::create("a, b")));
+    ASSERT_EQ(2, headers->getCPtr<JsArray>(LHEADER_SET_COOKIE)->length());
+    ASSERT_TRUE(headers->getCPtr<String>(String::create("foo"))->equals(
+        String::create("bar")));
+
+    msg->setHeader(String::create("Date"), String::create("now"));
+    ASSERT_EQ(6, msg->headers()->size());
+}
+
+TEST(GTestHttpHeader, TestHeaderBlock) {
+    JsObject::Ptr headers = JsObject::create();
+    headers->put(HEADER_SERVER, String::create("libnode"));
+    HeaderBlock::Ptr block = HeaderBlock::create(headers);
+    ASSERT_TRUE(block->serialized()->equals(
+        String::create("Server: libnode\r\n")));
+    ASSERT_TRUE(block->bytes()->toString()->equals(block->serialized()));
+    ASSERT_EQ(0, block->specials());
+    ASSERT_TRUE(block->getCPtr<String>(HEADER_SERVER)->equals(
+        String::create("libnode")));
+
+    JsArray::Ptr cookies = JsArray::create();
+    cookies->add(String::create("a=1"));
+    cookies->add(String::create("b=2"));
+    headers = JsObject::create();
+    headers->put(HEADER_SET_COOKIE, cookies);
+    block = HeaderBlock::create(headers);
+    ASSERT_TRUE(block->serialized()->equals(
+        String::create("Set-Cookie: a=1\r\nSet-Cookie: b=2\r\n")));
+
+    headers = JsObject::create();
+    headers->put(String::create("connection"), String::create("close"));
+    block = HeaderBlock::create(headers);
+    ASSERT_EQ(
+        HeaderBlock::CONNECTION | HeaderBlock::CONNECTION_CLOSE,
+        block->specials());
+
+    headers = JsObject::create();
+    headers->put(HEADER_TRANSFER_ENCODING, String::create("chunked"));
+    block = HeaderBlock::create(headers);
+    ASSERT_EQ(
+        HeaderBlock::TRANSFER_ENCODING | HeaderBlock::CHUNKED,
+        block->specials());
+
+    ASSERT_TRUE(HeaderBlock::create(JsObject::null())->serialized()
+        ->isEmpty());
+}
+
+TEST(GTestHttpHeader, TestDateHeaderLine) {
+    std::string line = dateHeaderLine();
+    ASSERT_EQ(37, line.length());
+    ASSERT_EQ(std::string("Date: "), line.substr(0, 6));
+    ASSERT_EQ(std::string(" GMT\r\n"), line.substr(31));
+    ASSERT_EQ(',', line[9]);
+
+    // the same line until the second is over
+    ASSERT_EQ(&dateHeaderLine(), &dateHeaderLine());
+}
+
+TEST(GTestHttpHeader, TestStatusLine) {
+    ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"), *statusLine(200));
+    ASSERT_EQ(
+        std::string("HTTP/1.1 431 Request Header Fields Too Large\r\n"),
+        *statusLine(431));
+    ASSERT_FALSE(statusLine(299));
+    ASSERT_FALSE(statusLine(0));
+    ASSERT_FALSE(statusLine(1000));
+}
+
+TEST(GTestHttpHeader, TestHeaderBuffer) {
+    HeaderBuffer header;
+    header.append("HTTP/1.1 200 OK\r\n");
+    header.append(HEADER_CONTENT_LENGTH);
+    header.append(": ");
+    header.appendDecimal(12);
+    header.append("\r\n");
+    header.append(String::create("X-Name: \xe3\x81\x82", String::UTF8));
+    header.append("\r\n");
+
+    Buffer::CPtr buf = header.toBuffer();
+    ASSERT_EQ(header.length(), buf->length());
+    ASSERT_TRUE(buf->toString()->equals(String::create(
+        "HTTP/1.1 200 OK\r\nContent-Length: 12\r\n"
+        "X-Name: \xe3\x81\x82\r\n", String::UTF8)));
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
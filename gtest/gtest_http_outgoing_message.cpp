@@ -0,0 +1,64 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../src/http/outgoing_message.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+TEST(GTestHttpOutgoingMessage, TestOutputSize) {
+    OutgoingMessage::Ptr msg = OutgoingMessage::create();
+    msg->setFlag(OutgoingMessage::SERVER_RESPONSE);
+    ASSERT_EQ(0, msg->outputSize());
+
+    // queued with the header and the chunk framing until a socket comes
+    ASSERT_TRUE(msg->write(String::create("abc"), Buffer::NONE));
+    Size size = msg->outputSize();
+    ASSERT_TRUE(msg->headerStored());
+    ASSERT_LT(3, size);
+
+    ASSERT_TRUE(msg->write(Buffer::create(1024), Buffer::NONE));
+    ASSERT_LT(size + 1024, msg->outputSize());
+
+    ASSERT_FALSE(msg->write(Buffer::create(16 * 1024), Buffer::NONE));
+}
+
+static OutgoingMessage::Ptr createHeadResponse(Boolean compression) {
+    OutgoingMessage::Ptr msg = OutgoingMessage::create();
+    msg->setFlag(OutgoingMessage::SERVER_RESPONSE);
+    msg->unsetFlag(OutgoingMessage::HAS_BODY);
+    if (compression) msg->setCompression(Compressor::GZIP, -1, 0, 0);
+    msg->setHeader(HEADER_CONTENT_TYPE, String::create("text/html"));
+    msg->setHeader(HEADER_CONTENT_LENGTH, String::valueOf(2048));
+    return msg;
+}
+
+TEST(GTestHttpOutgoingMessage, TestHeadWithoutCompression) {
+    String::CPtr body = String::create(std::string(2048, 'a').c_str());
+
+    // the same header and no body, with or without compression
+    OutgoingMessage::Ptr plain = createHeadResponse(false);
+    plain->end(body, Buffer::NONE);
+    OutgoingMessage::Ptr head = createHeadResponse(true);
+    head->end(body, Buffer::NONE);
+    ASSERT_EQ(plain->outputSize(), head->outputSize());
+    ASSERT_TRUE(head->getHeader(HEADER_CONTENT_LENGTH));
+    ASSERT_FALSE(head->getHeader(HEADER_CONTENT_ENCODING));
+
+    plain = createHeadResponse(false);
+    plain->writeHead(200);
+    plain->end(UNDEFINED, Buffer::NONE);
+    head = createHeadResponse(true);
+    head->writeHead(200);
+    head->end(UNDEFINED, Buffer::NONE);
+    ASSERT_EQ(plain->outputSize(), head->outputSize());
+    ASSERT_TRUE(head->getHeader(HEADER_CONTENT_LENGTH));
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
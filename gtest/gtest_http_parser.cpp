@@ -0,0 +1,461 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/buffer.h>
+#include <string.h>
+
+#include "../src/http/parser.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+static const char* request =
+    "GET /foo/bar?abc=123 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: libnode-gtest\r\n"
+    "Accept: text/html,application/xhtml+xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char* browserRequest =
+    "GET /wiki/Hypertext_Transfer_Protocol HTTP/1.1\r\n"
+    "Host: en.wikipedia.org\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,*/*;q=0.8\r\n"
+    "Referer: https://en.wikipedia.org/wiki/Main_Page\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,ja;q=0.8\r\n"
+    "Cookie: WMF-Last-Access=18-Oct-2012; GeoIP=JP:13:Tokyo:35.69:139.69:v4; "
+    "enwikimwuser-sessionId=5a1e2b3c4d5e6f708192\r\n"
+    "\r\n";
+
+class GTestHttpParserOnIncoming : LIBJ_JS_FUNCTION(GTestHttpParserOnIncoming)
+ public:
+    static Ptr create() {
+        return Ptr(new GTestHttpParserOnIncoming());
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        incoming_ = args->getPtr<IncomingMessage>(0);
+        count_++;
+        return false;
+    }
+
+    Size count() const { return count_; }
+
+    IncomingMessage::Ptr incoming() const { return incoming_; }
+
+ private:
+    Size count_;
+    IncomingMessage::Ptr incoming_;
+
+    GTestHttpParserOnIncoming()
+        : count_(0)
+        , incoming_(IncomingMessage::null()) {}
+};
+
+class GTestHttpParserOnData : LIBJ_JS_FUNCTION(GTestHttpParserOnData)
+ public:
+    static Ptr create() {
+        return Ptr(new GTestHttpParserOnData());
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        chunks_->add(args->get(0));
+        return libj::Status::OK;
+    }
+
+    JsArray::CPtr chunks() const { return chunks_; }
+
+ private:
+    JsArray::Ptr chunks_;
+
+    GTestHttpParserOnData() : chunks_(JsArray::create()) {}
+};
+
+class GTestHttpParserOnBody : LIBJ_JS_FUNCTION(GTestHttpParserOnBody)
+ public:
+    static Ptr create() {
+        return Ptr(new GTestHttpParserOnBody());
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        count_++;
+        err_ = args->get(0);
+        body_ = args->getCPtr<Buffer>(1);
+        return libj::Status::OK;
+    }
+
+    Size count() const { return count_; }
+
+    Value error() const { return err_; }
+
+    Buffer::CPtr body() const { return body_; }
+
+ private:
+    Size count_;
+    Value err_;
+    Buffer::CPtr body_;
+
+    GTestHttpParserOnBody()
+        : count_(0)
+        , body_(Buffer::null()) {}
+};
+
+// pauses the parser as the server does when the pipeline is full
+class GTestHttpParserOnPipelined : LIBJ_JS_FUNCTION(GTestHttpParserOnPipelined)
+ public:
+    static Ptr create(Parser* parser, Size maxDepth) {
+        return Ptr(new GTestHttpParserOnPipelined(parser, maxDepth));
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        if (++count_ > maxDepth_) parser_->pause();
+        return false;
+    }
+
+    Size count() const { return count_; }
+
+    void setMaxDepth(Size maxDepth) { maxDepth_ = maxDepth; }
+
+ private:
+    Parser* parser_;
+    Size maxDepth_;
+    Size count_;
+
+    GTestHttpParserOnPipelined(Parser* parser, Size maxDepth)
+        : parser_(parser)
+        , maxDepth_(maxDepth)
+        , count_(0) {}
+};
+
+static net::SocketImpl::Ptr createSocket() {
+    return net::SocketImpl::create(static_cast<uv::Stream*>(NULL), false);
+}
+
+TEST(GTestHttpParser, TestSplitHeaders) {
+    LIBJ_STATIC_SYMBOL_DEF(symHost,       "host");
+    LIBJ_STATIC_SYMBOL_DEF(symAccept,     "accept");
+    LIBJ_STATIC_SYMBOL_DEF(symConnection, "connection");
+
+    Size len = strlen(request);
+    for (Size i = 1; i < len; i++) {
+        GTestHttpParserOnIncoming::Ptr onIncoming =
+            GTestHttpParserOnIncoming::create();
+        Parser parser(HTTP_REQUEST, createSocket());
+        parser.setOnIncoming(onIncoming);
+
+        // the first buffer is gone before the second one is parsed
+        Buffer::CPtr buf1 = Buffer::create(request, i);
+        ASSERT_EQ(i, parser.execute(buf1));
+        buf1 = Buffer::null();
+        Buffer::CPtr buf2 = Buffer::create(request + i, len - i);
+        ASSERT_EQ(len - i, parser.execute(buf2));
+
+        ASSERT_EQ(1, onIncoming->count());
+        IncomingMessage::Ptr msg = onIncoming->incoming();
+        ASSERT_TRUE(msg->method()->equals(String::create("GET")));
+        ASSERT_TRUE(msg->url()->equals(String::create("/foo/bar?abc=123")));
+        JsObject::CPtr headers = msg->headers();
+        ASSERT_TRUE(headers->getCPtr<String>(symHost)->equals(
+            String::create("www.example.com")));
+        ASSERT_TRUE(headers->getCPtr<String>(symAccept)->equals(
+            String::create(
+                "text/html,application/xhtml+xml;q=0.9,*/*;q=0.8")));
+        ASSERT_TRUE(headers->getCPtr<String>(symConnection)->equals(
+            String::create("keep-alive")));
+        parser.free();
+    }
+}
+
+TEST(GTestHttpParser, TestMethodAndVersion) {
+    const char* reqs =
+        "PATCH /a HTTP/1.1\r\n\r\n"
+        "M-SEARCH * HTTP/1.1\r\n\r\n"
+        "GET /b HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+
+    for (Size i = 0; i < 2; i++) {
+        GTestHttpParserOnIncoming::Ptr onIncoming =
+            GTestHttpParserOnIncoming::create();
+        Parser parser(HTTP_REQUEST, createSocket());
+        parser.setFastScan(i == 1);
+        parser.setOnIncoming(onIncoming);
+
+        Size len = strlen(reqs);
+        Size first = strlen("PATCH /a HTTP/1.1\r\n\r\n");
+        ASSERT_EQ(first, parser.execute(Buffer::create(reqs, first)));
+        IncomingMessage::Ptr msg = onIncoming->incoming();
+        ASSERT_EQ(METHOD_PATCH, msg->methodCode());
+        ASSERT_TRUE(msg->method()->equals(String::create("PATCH")));
+        ASSERT_EQ(HTTP_VERSION_1_1, msg->httpVersion());
+        ASSERT_EQ(1, msg->httpVersionMajor());
+        ASSERT_EQ(1, msg->httpVersionMinor());
+
+        Buffer::CPtr rest = Buffer::create(reqs + first, len - first);
+        ASSERT_EQ(len - first, parser.execute(rest));
+        ASSERT_EQ(3, onIncoming->count());
+        msg = onIncoming->incoming();
+        ASSERT_EQ(METHOD_GET, msg->methodCode());
+        ASSERT_EQ(HTTP_VERSION_1_0, msg->httpVersion());
+        ASSERT_EQ(0, msg->httpVersionMinor());
+        parser.free();
+    }
+
+    ASSERT_EQ(METHOD_MSEARCH, toMethod(String::create("M-SEARCH")));
+    ASSERT_EQ(METHOD_UNKNOWN, toMethod(String::create("get")));
+    ASSERT_TRUE(methodName(METHOD_PURGE)->equals(String::create("PURGE")));
+}
+
+TEST(GTestHttpParser, TestMaxHeadersCount) {
+    GTestHttpParserOnIncoming::Ptr onIncoming =
+        GTestHttpParserOnIncoming::create();
+    Parser parser(HTTP_REQUEST, createSocket(), 2);
+    parser.setOnIncoming(onIncoming);
+
+    Buffer::CPtr buf = Buffer::create(request, strlen(request));
+    ASSERT_EQ(buf->length(), parser.execute(buf));
+    ASSERT_EQ(1, onIncoming->count());
+    ASSERT_EQ(2, onIncoming->incoming()->headers()->size());
+    parser.free();
+}
+
+TEST(GTestHttpParser, TestMaxHeaderSize) {
+    Size len = strlen(request);
+    for (Size i = 0; i < 2; i++) {
+        GTestHttpParserOnIncoming::Ptr onIncoming =
+            GTestHttpParserOnIncoming::create();
+        Parser parser(HTTP_REQUEST, createSocket());
+        parser.setOnIncoming(onIncoming);
+        parser.setFastScan(i == 1);
+        parser.setMaxHeaderSize(32);
+        ASSERT_TRUE(parser.messageStart());
+
+        Buffer::CPtr buf = Buffer::create(request, len);
+        ASSERT_EQ(-1, parser.execute(buf));
+        ASSERT_TRUE(parser.headerOverflow());
+        ASSERT_FALSE(parser.headersComplete());
+        ASSERT_EQ(0, onIncoming->count());
+        parser.free();
+
+        onIncoming = GTestHttpParserOnIncoming::create();
+        Parser parser2(HTTP_REQUEST, createSocket());
+        parser2.setOnIncoming(onIncoming);
+        parser2.setFastScan(i == 1);
+        parser2.setMaxHeaderSize(len);
+        ASSERT_EQ(len, parser2.execute(buf));
+        ASSERT_FALSE(parser2.headerOverflow());
+        ASSERT_EQ(1, onIncoming->count());
+        ASSERT_FALSE(parser2.messageStart());
+        parser2.free();
+    }
+}
+
+TEST(GTestHttpParser, TestBodyWithoutCopy) {
+    const char* head =
+        "POST /upload HTTP/1.1\r\n"
+        "Content-Length: 10\r\n"
+        "\r\n"
+        "01234";
+
+    GTestHttpParserOnIncoming::Ptr onIncoming =
+        GTestHttpParserOnIncoming::create();
+    Parser parser(HTTP_REQUEST, createSocket());
+    parser.setOnIncoming(onIncoming);
+
+    Buffer::CPtr buf1 = Buffer::create(head, strlen(head));
+    ASSERT_EQ(buf1->length(), parser.execute(buf1));
+    ASSERT_EQ(1, onIncoming->count());
+
+    GTestHttpParserOnData::Ptr onData = GTestHttpParserOnData::create();
+    onIncoming->incoming()->on(ReadableStream::EVENT_DATA, onData);
+    Buffer::CPtr buf2 = Buffer::create("56789", 5);
+    ASSERT_EQ(5, parser.execute(buf2));
+
+    JsArray::CPtr chunks = onData->chunks();
+    ASSERT_EQ(1, chunks->length());
+    ASSERT_EQ(buf2, chunks->getCPtr<Buffer>(0));
+    parser.free();
+}
+
+static GTestHttpParserOnBody::Ptr readBody(
+    const char* head,
+    const char* body,
+    Size limit) {
+    GTestHttpParserOnIncoming::Ptr onIncoming =
+        GTestHttpParserOnIncoming::create();
+    Parser parser(HTTP_REQUEST, createSocket());
+    parser.setOnIncoming(onIncoming);
+
+    Buffer::CPtr buf = Buffer::create(head, strlen(head));
+    EXPECT_EQ(buf->length(), parser.execute(buf));
+    EXPECT_EQ(1, onIncoming->count());
+
+    GTestHttpParserOnBody::Ptr onBody = GTestHttpParserOnBody::create();
+    onIncoming->incoming()->readBody(limit, onBody);
+    Size len = strlen(body);
+    for (Size i = 0; i < len; i += 4) {
+        Size n = len - i < 4 ? len - i : 4;
+        buf = Buffer::create(body + i, n);
+        EXPECT_EQ(n, parser.execute(buf));
+    }
+    parser.free();
+    return onBody;
+}
+
+TEST(GTestHttpParser, TestReadBody) {
+    const char* head =
+        "POST /upload HTTP/1.1\r\n"
+        "Content-Length: 10\r\n"
+        "\r\n"
+        "012";
+    GTestHttpParserOnBody::Ptr onBody = readBody(head, "3456789", 10);
+    ASSERT_EQ(1, onBody->count());
+    ASSERT_TRUE(onBody->error().isNull());
+    ASSERT_TRUE(onBody->body()->toString()->equals(
+        String::create("0123456789")));
+
+    onBody = readBody(head, "3456789", 9);
+    ASSERT_EQ(1, onBody->count());
+    http::Status::CPtr status = toCPtr<http::Status>(onBody->error());
+    ASSERT_EQ(http::Status::REQUEST_ENTITY_TOO_LARGE, status->code());
+    ASSERT_FALSE(onBody->body());
+}
+
+TEST(GTestHttpParser, TestReadChunkedBody) {
+    const char* head =
+        "POST /upload HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n";
+    const char* body =
+        "5\r\nhello\r\n"
+        "6\r\n world\r\n"
+        "0\r\n\r\n";
+    GTestHttpParserOnBody::Ptr onBody = readBody(head, body, 100);
+    ASSERT_EQ(1, onBody->count());
+    ASSERT_TRUE(onBody->body()->toString()->equals(
+        String::create("hello world")));
+
+    onBody = readBody(head, body, 8);
+    ASSERT_EQ(1, onBody->count());
+    ASSERT_FALSE(onBody->body());
+}
+
+TEST(GTestHttpParser, TestFreeList) {
+    Parser::setMaxFree(1);
+    ASSERT_EQ(0, Parser::numFree());
+
+    GTestHttpParserOnIncoming::Ptr onIncoming =
+        GTestHttpParserOnIncoming::create();
+    Parser* parser = Parser::create(HTTP_REQUEST, createSocket());
+    Parser* other = Parser::create(HTTP_REQUEST, createSocket());
+    parser->setOnIncoming(onIncoming);
+    Buffer::CPtr buf = Buffer::create(request, 10);
+    ASSERT_EQ(10, parser->execute(buf));
+
+    Parser::release(parser);
+    Parser::release(parser);
+    ASSERT_EQ(1, Parser::numFree());
+    Parser::release(other);
+    ASSERT_EQ(1, Parser::numFree());
+
+    // the half-parsed request is gone
+    Parser* reused = Parser::create(HTTP_REQUEST, createSocket());
+    ASSERT_EQ(parser, reused);
+    ASSERT_EQ(0, Parser::numFree());
+    reused->setOnIncoming(onIncoming);
+    buf = Buffer::create(request, strlen(request));
+    ASSERT_EQ(buf->length(), reused->execute(buf));
+    ASSERT_EQ(1, onIncoming->count());
+    ASSERT_TRUE(onIncoming->incoming()->url()->equals(
+        String::create("/foo/bar?abc=123")));
+
+    Parser::release(reused);
+    Parser::setMaxFree(0);
+    ASSERT_EQ(0, Parser::numFree());
+    Parser::setMaxFree(1000);
+}
+
+TEST(GTestHttpParser, TestFastScan) {
+    LIBJ_STATIC_SYMBOL_DEF(symCookie, "cookie");
+
+    GTestHttpParserOnIncoming::Ptr onIncoming =
+        GTestHttpParserOnIncoming::create();
+    Parser parser(HTTP_REQUEST, createSocket());
+    parser.setFastScan(true);
+    parser.setOnIncoming(onIncoming);
+
+    // a request with a body goes to http_parser in the middle
+    std::string reqs(browserRequest);
+    reqs.append(
+        "POST /form HTTP/1.1\r\n"
+        "Content-Length: 3\r\n"
+        "\r\n"
+        "a=b");
+    reqs.append(request);
+    Buffer::CPtr buf = Buffer::create(reqs.data(), reqs.length());
+    ASSERT_EQ(buf->length(), parser.execute(buf));
+    ASSERT_EQ(3, onIncoming->count());
+    ASSERT_TRUE(onIncoming->incoming()->url()->equals(
+        String::create("/foo/bar?abc=123")));
+
+    buf = Buffer::create(browserRequest, strlen(browserRequest));
+    ASSERT_EQ(buf->length(), parser.execute(buf));
+    ASSERT_EQ(4, onIncoming->count());
+    IncomingMessage::Ptr msg = onIncoming->incoming();
+    ASSERT_TRUE(msg->method()->equals(String::create("GET")));
+    ASSERT_TRUE(msg->httpVersion()->equals(String::create("1.1")));
+    ASSERT_EQ(10, msg->headers()->size());
+    ASSERT_TRUE(msg->getHeader(symCookie)->startsWith(
+        String::create("WMF-Last-Access=")));
+    parser.free();
+}
+
+static void testPipelineDepth(Boolean fastScan) {
+    const Size maxDepth = 32;
+    const Size numRequests = 40;
+
+    std::string reqs;
+    for (Size i = 0; i < numRequests; i++) reqs.append(request);
+    Buffer::CPtr buf = Buffer::create(reqs.data(), reqs.length());
+
+    Parser parser(HTTP_REQUEST, createSocket());
+    parser.setFastScan(fastScan);
+    GTestHttpParserOnPipelined::Ptr onIncoming =
+        GTestHttpParserOnPipelined::create(&parser, maxDepth);
+    parser.setOnIncoming(onIncoming);
+
+    // the requests after a full pipeline are held, not dispatched
+    ASSERT_EQ(buf->length(), parser.execute(buf));
+    ASSERT_EQ(maxDepth + 1, onIncoming->count());
+    ASSERT_TRUE(parser.paused());
+    ASSERT_EQ((numRequests - maxDepth - 1) * strlen(request),
+              parser.heldSize());
+
+    // more data waits behind them
+    Buffer::CPtr last = Buffer::create(request, strlen(request));
+    ASSERT_EQ(last->length(), parser.execute(last));
+    ASSERT_EQ(maxDepth + 1, onIncoming->count());
+
+    onIncoming->setMaxDepth(numRequests + 1);
+    parser.resume();
+    ASSERT_FALSE(parser.paused());
+    ASSERT_EQ(numRequests + 1, onIncoming->count());
+    ASSERT_EQ(0, parser.heldSize());
+    parser.free();
+}
+
+TEST(GTestHttpParser, TestPipelineDepth) {
+    testPipelineDepth(false);
+    testPipelineDepth(true);
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
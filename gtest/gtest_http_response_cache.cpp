@@ -0,0 +1,160 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <libj/js_object.h>
+
+#include <string>
+
+#include "../src/http/response_cache.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+class GTestCacheRequest : public ResponseCache::Request {
+ public:
+    GTestCacheRequest(
+        const char* url,
+        JsObject::CPtr headers = JsObject::null(),
+        Method method = METHOD_GET)
+        : method_(method)
+        , url_(String::create(url))
+        , headers_(headers) {}
+
+    Method method() const {
+        return method_;
+    }
+
+    String::CPtr url() const {
+        return url_;
+    }
+
+    String::CPtr header(String::CPtr name) const {
+        return headers_ ? headers_->getCPtr<String>(name) : String::null();
+    }
+
+ private:
+    Method method_;
+    String::CPtr url_;
+    JsObject::CPtr headers_;
+};
+
+static Boolean store(
+    ResponseCache* cache,
+    GTestCacheRequest* req,
+    const char* cacheControl,
+    const std::string& body,
+    const char* vary = NULL) {
+    ResponseCache::Recording* recording = cache->record(req);
+    if (!recording) return false;
+
+    Boolean ok = recording->start(
+        200,
+        "HTTP/1.1 200 OK\r\n",
+        cacheControl ? String::create(cacheControl) : String::null(),
+        vary ? String::create(vary) : String::null(),
+        false,
+        false,
+        false) &&
+        recording->append(body.data(), body.length());
+    recording->finish();
+    delete recording;
+    return ok;
+}
+
+TEST(GTestHttpResponseCache, TestHitAndMiss) {
+    ResponseCache cache(64 * 1024);
+    GTestCacheRequest req("/a");
+    ASSERT_FALSE(cache.lookup(req));
+    ASSERT_EQ(1, cache.misses());
+
+    ASSERT_TRUE(store(&cache, new GTestCacheRequest("/a"), "max-age=60", "A"));
+    const CachedResponse* cached = cache.lookup(req);
+    ASSERT_TRUE(cached);
+    ASSERT_EQ(200, cached->statusCode());
+    ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"), cached->head());
+    ASSERT_EQ(std::string("A"), cached->body());
+    ASSERT_EQ(1, cache.hits());
+    ASSERT_EQ(1, cache.entries());
+
+    ASSERT_FALSE(cache.lookup(GTestCacheRequest("/b")));
+    ASSERT_FALSE(cache.lookup(GTestCacheRequest("/a", JsObject::null(),
+                                                 METHOD_POST)));
+    ASSERT_EQ(1, cache.hits());
+}
+
+TEST(GTestHttpResponseCache, TestCacheControl) {
+    ResponseCache cache(64 * 1024);
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/a"), NULL, "A"));
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/a"), "max-age=0", "A"));
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/a"),
+                       "private, max-age=60", "A"));
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/a"),
+                       "no-store", "A"));
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/a"),
+                       "max-age=60", "A", "*"));
+    ASSERT_EQ(0, cache.entries());
+
+    ASSERT_TRUE(store(&cache, new GTestCacheRequest("/a"),
+                      "public, s-maxage=60, max-age=0", "A"));
+    ASSERT_EQ(1, cache.entries());
+
+    // the client bypasses the cache
+    JsObject::Ptr headers = JsObject::create();
+    headers->put(String::create("cache-control"), String::create("no-cache"));
+    ASSERT_FALSE(cache.lookup(GTestCacheRequest("/a", headers)));
+    ASSERT_TRUE(cache.lookup(GTestCacheRequest("/a")));
+
+    headers = JsObject::create();
+    headers->put(String::create("authorization"), String::create("Basic x"));
+    ASSERT_FALSE(cache.record(new GTestCacheRequest("/a", headers)));
+}
+
+TEST(GTestHttpResponseCache, TestVary) {
+    ResponseCache cache(64 * 1024);
+    JsObject::Ptr gzip = JsObject::create();
+    gzip->put(String::create("accept-encoding"), String::create("gzip"));
+    JsObject::Ptr none = JsObject::create();
+
+    ASSERT_TRUE(store(&cache, new GTestCacheRequest("/a", gzip),
+                      "max-age=60", "gzipped", "Accept-Encoding"));
+    ASSERT_TRUE(store(&cache, new GTestCacheRequest("/a", none),
+                      "max-age=60", "plain", "Accept-Encoding"));
+    ASSERT_EQ(2, cache.entries());
+
+    ASSERT_EQ(std::string("gzipped"),
+        cache.lookup(GTestCacheRequest("/a", gzip))->body());
+    ASSERT_EQ(std::string("plain"),
+        cache.lookup(GTestCacheRequest("/a", none))->body());
+}
+
+TEST(GTestHttpResponseCache, TestEviction) {
+    // 8 KiB per entry at most
+    ResponseCache cache(64 * 1024);
+    std::string body(6 * 1024, 'x');
+    ASSERT_FALSE(store(&cache, new GTestCacheRequest("/large"),
+                       "max-age=60", std::string(9 * 1024, 'x')));
+
+    char url[16];
+    for (Size i = 0; i < 10; i++) {
+        snprintf(url, sizeof(url), "/%d", static_cast<int>(i));
+        ASSERT_TRUE(store(&cache, new GTestCacheRequest(url),
+                          "max-age=60", body));
+
+        // '/0' is kept as the most recently used
+        ASSERT_TRUE(cache.lookup(GTestCacheRequest("/0")));
+    }
+    ASSERT_EQ(10, cache.entries());
+
+    ASSERT_TRUE(store(&cache, new GTestCacheRequest("/10"),
+                      "max-age=60", body));
+    ASSERT_EQ(1, cache.evictions());
+    ASSERT_LE(cache.size(), 64 * 1024);
+    ASSERT_TRUE(cache.lookup(GTestCacheRequest("/0")));
+    ASSERT_FALSE(cache.lookup(GTestCacheRequest("/1")));
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
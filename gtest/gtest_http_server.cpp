@@ -1,15 +1,301 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
 #include <gtest/gtest.h>
+#include <libj/status.h>
 #include <libnode/http/server.h>
+#include <libnode/http/server_response.h>
+#include <libnode/net.h>
+#include <libnode/node.h>
+#include <libnode/timer.h>
+
+#include <string>
 
 namespace libj {
 namespace node {
 
+static const Int PORT = 10002;
+
+static Size countOf(const std::string& str, const char* s) {
+    Size n = 0;
+    std::string::size_type pos = str.find(s);
+    while (pos != std::string::npos) {
+        n++;
+        pos = str.find(s, pos + 1);
+    }
+    return n;
+}
+
+class GTestHttpServerOnRequest : LIBJ_JS_FUNCTION(GTestHttpServerOnRequest)
+ public:
+    static Ptr create(Boolean keepAlive = false) {
+        return Ptr(new GTestHttpServerOnRequest(keepAlive));
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        http::ServerResponse::Ptr res =
+            toPtr<http::ServerResponse>(args->get(1));
+        count_++;
+        res->setHeader(http::HEADER_CONTENT_LENGTH, String::valueOf(2));
+        if (keepAlive_) {
+            res->setHeader(
+                http::HEADER_CONNECTION,
+                String::create("keep-alive"));
+        }
+        res->end(String::create("ok"));
+        return Status::OK;
+    }
+
+    Size count() const { return count_; }
+
+ private:
+    Boolean keepAlive_;
+    Size count_;
+
+    GTestHttpServerOnRequest(Boolean keepAlive)
+        : keepAlive_(keepAlive)
+        , count_(0) {}
+};
+
+// connects when the timer fires, sends the request as it is
+// and keeps all the bytes it receives
+class GTestHttpServerClient : LIBJ_JS_FUNCTION(GTestHttpServerClient)
+ public:
+    static Ptr create(const char* request) {
+        return Ptr(new GTestHttpServerClient(request));
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        socket_ = net::createConnection(PORT);
+        socket_->on(net::Socket::EVENT_DATA, OnData::create(this));
+        socket_->on(net::Socket::EVENT_CLOSE, OnClose::create(this));
+        if (!request_.empty()) {
+            socket_->write(String::create(request_.c_str()));
+        }
+        return Status::OK;
+    }
+
+    const std::string& received() const { return received_; }
+
+    Boolean closed() const { return closed_; }
+
+    void destroy() {
+        if (socket_ && !closed_) socket_->destroy();
+    }
+
+ private:
+    class OnData : LIBJ_JS_FUNCTION(OnData)
+     public:
+        static Ptr create(GTestHttpServerClient* client) {
+            return Ptr(new OnData(client));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            Buffer::CPtr buf = args->getCPtr<Buffer>(0);
+            if (buf) {
+                client_->received_.append(
+                    static_cast<const char*>(buf->data()),
+                    buf->length());
+            }
+            return Status::OK;
+        }
+
+     private:
+        GTestHttpServerClient* client_;
+
+        OnData(GTestHttpServerClient* client) : client_(client) {}
+    };
+
+    class OnClose : LIBJ_JS_FUNCTION(OnClose)
+     public:
+        static Ptr create(GTestHttpServerClient* client) {
+            return Ptr(new OnClose(client));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            client_->closed_ = true;
+            return Status::OK;
+        }
+
+     private:
+        GTestHttpServerClient* client_;
+
+        OnClose(GTestHttpServerClient* client) : client_(client) {}
+    };
+
+    std::string request_;
+    std::string received_;
+    Boolean closed_;
+    net::Socket::Ptr socket_;
+
+    GTestHttpServerClient(const char* request)
+        : request_(request)
+        , closed_(false)
+        , socket_(net::Socket::null()) {}
+};
+
+// whether the client had been closed when the timer fired
+class GTestHttpServerProbe : LIBJ_JS_FUNCTION(GTestHttpServerProbe)
+ public:
+    static Ptr create(GTestHttpServerClient::Ptr client) {
+        return Ptr(new GTestHttpServerProbe(client));
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        closed_ = client_->closed();
+        return Status::OK;
+    }
+
+    Boolean closed() const { return closed_; }
+
+ private:
+    GTestHttpServerClient::Ptr client_;
+    Boolean closed_;
+
+    GTestHttpServerProbe(GTestHttpServerClient::Ptr client)
+        : client_(client)
+        , closed_(false) {}
+};
+
+// lets node::run() return
+class GTestHttpServerStop : LIBJ_JS_FUNCTION(GTestHttpServerStop)
+ public:
+    static Ptr create(http::Server::Ptr srv, JsArray::Ptr clients) {
+        return Ptr(new GTestHttpServerStop(srv, clients));
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        for (Size i = 0; i < clients_->length(); i++) {
+            clients_->getPtr<GTestHttpServerClient>(i)->destroy();
+        }
+        srv_->close();
+        return Status::OK;
+    }
+
+ private:
+    http::Server::Ptr srv_;
+    JsArray::Ptr clients_;
+
+    GTestHttpServerStop(http::Server::Ptr srv, JsArray::Ptr clients)
+        : srv_(srv)
+        , clients_(clients) {}
+};
+
+static const char* get =
+    "GET / HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
 TEST(GTestHttpServer, TestCreate) {
     http::Server::Ptr srv = http::Server::create();
     ASSERT_TRUE(srv);
 }
 
+TEST(GTestHttpServer, TestKeepAliveTimeout) {
+    JsObject::Ptr options = JsObject::create();
+    options->put(String::create("keepAliveTimeout"), 300);
+    http::Server::Ptr srv = http::Server::create(options);
+    srv->on(http::Server::EVENT_REQUEST, GTestHttpServerOnRequest::create());
+    srv->listen(PORT);
+
+    // one sends nothing, and the other is answered once
+    GTestHttpServerClient::Ptr silent = GTestHttpServerClient::create("");
+    GTestHttpServerClient::Ptr served = GTestHttpServerClient::create(get);
+    setTimeout(silent, 100);
+    setTimeout(served, 100);
+
+    // both have been idle for less than keepAliveTimeout at the first
+    // check after they connect, and for more at the second
+    GTestHttpServerProbe::Ptr silentBefore =
+        GTestHttpServerProbe::create(silent);
+    GTestHttpServerProbe::Ptr servedBefore =
+        GTestHttpServerProbe::create(served);
+    GTestHttpServerProbe::Ptr silentAfter =
+        GTestHttpServerProbe::create(silent);
+    GTestHttpServerProbe::Ptr servedAfter =
+        GTestHttpServerProbe::create(served);
+    setTimeout(silentBefore, 450);
+    setTimeout(servedBefore, 450);
+    setTimeout(silentAfter, 900);
+    setTimeout(servedAfter, 900);
+
+    JsArray::Ptr clients = JsArray::create();
+    clients->add(silent);
+    clients->add(served);
+    setTimeout(GTestHttpServerStop::create(srv, clients), 950);
+    node::run();
+
+    ASSERT_FALSE(silentBefore->closed());
+    ASSERT_FALSE(servedBefore->closed());
+    ASSERT_TRUE(silentAfter->closed());
+    ASSERT_TRUE(servedAfter->closed());
+
+    // a timeout under a second is not advertised as 0
+    ASSERT_EQ(1, countOf(served->received(), "HTTP/1.1 200"));
+    ASSERT_EQ(1, countOf(served->received(), "Connection: keep-alive"));
+    ASSERT_EQ(0, countOf(served->received(), "Keep-Alive:"));
+}
+
+TEST(GTestHttpServer, TestMaxRequestsPerSocket) {
+    JsObject::Ptr options = JsObject::create();
+    options->put(String::create("maxRequestsPerSocket"), 2);
+    http::Server::Ptr srv = http::Server::create(options);
+    GTestHttpServerOnRequest::Ptr onRequest =
+        GTestHttpServerOnRequest::create();
+    srv->on(http::Server::EVENT_REQUEST, onRequest);
+    srv->listen(PORT);
+
+    // the last request allowed is answered with 'Connection: close'
+    std::string reqs;
+    for (Size i = 0; i < 3; i++) reqs.append(get);
+    GTestHttpServerClient::Ptr client =
+        GTestHttpServerClient::create(reqs.c_str());
+    setTimeout(client, 10);
+
+    JsArray::Ptr clients = JsArray::create();
+    clients->add(client);
+    setTimeout(GTestHttpServerStop::create(srv, clients), 500);
+    node::run();
+
+    ASSERT_EQ(2, onRequest->count());
+    ASSERT_EQ(2, countOf(client->received(), "HTTP/1.1 200"));
+    ASSERT_EQ(1, countOf(client->received(), "Connection: keep-alive"));
+    ASSERT_EQ(1, countOf(client->received(), "Connection: close"));
+    ASSERT_TRUE(client->closed());
+}
+
+TEST(GTestHttpServer, TestServiceUnavailable) {
+    JsObject::Ptr options = JsObject::create();
+    options->put(String::create("maxRequestsPerSocket"), 1);
+    http::Server::Ptr srv = http::Server::create(options);
+
+    // the handler keeps the connection open against the limit
+    GTestHttpServerOnRequest::Ptr onRequest =
+        GTestHttpServerOnRequest::create(true);
+    srv->on(http::Server::EVENT_REQUEST, onRequest);
+    srv->listen(PORT);
+
+    // the body of the request over the limit is not a request
+    std::string reqs(get);
+    reqs.append(
+        "POST /form HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Content-Length: 35\r\n"
+        "\r\n"
+        "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    GTestHttpServerClient::Ptr client =
+        GTestHttpServerClient::create(reqs.c_str());
+    setTimeout(client, 10);
+
+    JsArray::Ptr clients = JsArray::create();
+    clients->add(client);
+    setTimeout(GTestHttpServerStop::create(srv, clients), 500);
+    node::run();
+
+    ASSERT_EQ(1, onRequest->count());
+    ASSERT_EQ(1, countOf(client->received(), "HTTP/1.1 200"));
+    ASSERT_EQ(1, countOf(client->received(), "HTTP/1.1 503"));
+    ASSERT_TRUE(client->closed());
+}
+
 }  // namespace node
 }  // namespace libj
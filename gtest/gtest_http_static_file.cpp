@@ -0,0 +1,106 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../src/http/date_cache.h"
+#include "../src/http/static_file.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+TEST(GTestHttpStaticFile, TestMimeType) {
+    ASSERT_TRUE(mimeType(String::create("/index.html"))->equals(
+        String::create("text/html; charset=UTF-8")));
+    ASSERT_TRUE(mimeType(String::create("/a/b.min.JS"))->equals(
+        String::create("application/javascript; charset=UTF-8")));
+    ASSERT_TRUE(mimeType(String::create("/font.woff2"))->equals(
+        String::create("font/woff2")));
+    ASSERT_TRUE(mimeType(String::create("/a.zip"))->equals(
+        String::create("application/zip")));
+    ASSERT_TRUE(mimeType(String::create("/a.dir/README"))->equals(
+        String::create("application/octet-stream")));
+    ASSERT_TRUE(mimeType(String::create("/a.unknown"))->equals(
+        String::create("application/octet-stream")));
+}
+
+TEST(GTestHttpStaticFile, TestSafePath) {
+    ASSERT_TRUE(safePath(String::create("/a%20b/c.txt"))->equals(
+        String::create("/a b/c.txt")));
+    ASSERT_TRUE(safePath(String::create("/a+b"))->equals(
+        String::create("/a+b")));
+    ASSERT_TRUE(safePath(String::create("/..a/b..")));
+    ASSERT_FALSE(safePath(String::create("/../etc/passwd")));
+    ASSERT_FALSE(safePath(String::create("/a/%2e%2e/b")));
+    ASSERT_FALSE(safePath(String::create("/a/..")));
+    ASSERT_FALSE(safePath(String::create("/a%00.html")));
+    ASSERT_FALSE(safePath(String::create("/a%2")));
+    ASSERT_FALSE(safePath(String::create("a")));
+    ASSERT_FALSE(safePath(String::null()));
+}
+
+TEST(GTestHttpStaticFile, TestEtagMatches) {
+    std::string etag = entityTag(0x5f5e100, 1024);
+    ASSERT_EQ(std::string("\"5f5e100-400\""), etag);
+    ASSERT_TRUE(etagMatches(String::create("\"5f5e100-400\""), etag));
+    ASSERT_TRUE(etagMatches(String::create("W/\"5f5e100-400\""), etag));
+    ASSERT_TRUE(etagMatches(
+        String::create("\"x\", \"5f5e100-400\" "), etag));
+    ASSERT_TRUE(etagMatches(String::create("*"), etag));
+    ASSERT_FALSE(etagMatches(String::create("\"5f5e100-401\""), etag));
+    ASSERT_FALSE(etagMatches(String::null(), etag));
+}
+
+TEST(GTestHttpStaticFile, TestParseRange) {
+    Size first = 0;
+    Size last = 0;
+    ASSERT_EQ(RANGE_SATISFIABLE,
+        parseRange(String::create("bytes=0-99"), 1000, &first, &last));
+    ASSERT_EQ(0, first);
+    ASSERT_EQ(99, last);
+    ASSERT_EQ(RANGE_SATISFIABLE,
+        parseRange(String::create("bytes=900-"), 1000, &first, &last));
+    ASSERT_EQ(900, first);
+    ASSERT_EQ(999, last);
+    ASSERT_EQ(RANGE_SATISFIABLE,
+        parseRange(String::create("bytes=-100"), 1000, &first, &last));
+    ASSERT_EQ(900, first);
+    ASSERT_EQ(999, last);
+    ASSERT_EQ(RANGE_SATISFIABLE,
+        parseRange(String::create("bytes=500-5000"), 1000, &first, &last));
+    ASSERT_EQ(500, first);
+    ASSERT_EQ(999, last);
+
+    ASSERT_EQ(RANGE_UNSATISFIABLE,
+        parseRange(String::create("bytes=1000-"), 1000, &first, &last));
+    ASSERT_EQ(RANGE_UNSATISFIABLE,
+        parseRange(String::create("bytes=-0"), 1000, &first, &last));
+    ASSERT_EQ(RANGE_UNSATISFIABLE,
+        parseRange(String::create("bytes=0-"), 0, &first, &last));
+
+    ASSERT_EQ(RANGE_NONE,
+        parseRange(String::create("bytes=0-1,5-6"), 1000, &first, &last));
+    ASSERT_EQ(RANGE_NONE,
+        parseRange(String::create("bytes=9-1"), 1000, &first, &last));
+    ASSERT_EQ(RANGE_NONE,
+        parseRange(String::create("items=0-1"), 1000, &first, &last));
+    ASSERT_EQ(RANGE_NONE,
+        parseRange(String::null(), 1000, &first, &last));
+}
+
+TEST(GTestHttpStaticFile, TestHttpDate) {
+    ASSERT_EQ(std::string("Sun, 06 Nov 1994 08:49:37 GMT"),
+        httpDate(784111777));
+
+    time_t t = 0;
+    ASSERT_TRUE(parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", &t));
+    ASSERT_EQ(784111777, t);
+    ASSERT_FALSE(parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT", &t));
+    ASSERT_FALSE(parseHttpDate("yesterday", &t));
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,56 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libj/string.h>
+
+#include "../src/ring_queue.h"
+
+namespace libj {
+namespace node {
+
+TEST(GTestRingQueue, TestPushAndShift) {
+    RingQueue<Int> queue;
+    ASSERT_TRUE(queue.isEmpty());
+
+    queue.push(1);
+    queue.push(2);
+    ASSERT_EQ(2, queue.length());
+    ASSERT_EQ(1, queue.front());
+    ASSERT_EQ(2, queue.back());
+    ASSERT_EQ(1, queue.shift());
+    ASSERT_EQ(2, queue.shift());
+    ASSERT_TRUE(queue.isEmpty());
+}
+
+TEST(GTestRingQueue, TestWrapAndGrow) {
+    RingQueue<Int> queue;
+    Int pushed = 0;
+    Int shifted = 0;
+    for (Int i = 0; i < 100; i++) {
+        // the queue grows by one every round while wrapping around
+        queue.push(pushed++);
+        queue.push(pushed++);
+        ASSERT_EQ(shifted++, queue.shift());
+        ASSERT_EQ(pushed - 1, queue.back());
+        ASSERT_EQ(shifted, queue.front());
+    }
+    ASSERT_EQ(100, queue.length());
+    while (!queue.isEmpty()) {
+        ASSERT_EQ(shifted++, queue.shift());
+    }
+    ASSERT_EQ(pushed, shifted);
+}
+
+TEST(GTestRingQueue, TestClear) {
+    RingQueue<String::CPtr> queue;
+    String::CPtr str = String::create("abc");
+    queue.push(str);
+    queue.push(str);
+    queue.clear();
+    ASSERT_TRUE(queue.isEmpty());
+    queue.push(str);
+    ASSERT_TRUE(queue.shift()->equals(str));
+}
+
+}  // namespace node
+}  // namespace libj
@@ -4,6 +4,8 @@
 #define LIBNODE_HTTP_H_
 
 #include "libnode/http/header.h"
+#include "libnode/http/header_block.h"
+#include "libnode/http/method.h"
 #include "libnode/http/server.h"
 #include "libnode/http/server_request.h"
 #include "libnode/http/server_response.h"
@@ -15,6 +17,21 @@ namespace http {
 
 Server::Ptr createServer(JsFunction::Ptr requestListener = JsFunction::null());
 
+Server::Ptr createServer(
+    JsObject::CPtr options,
+    JsFunction::Ptr requestListener = JsFunction::null());
+
+// a request listener which serves the files under 'root'.
+// options:
+//   index        - the file for a directory, "index.html" by default
+//   maxAge       - Cache-Control max-age in seconds, 0 by default,
+//                  and no Cache-Control if it is negative
+//   etag         - whether to send ETag, true by default
+//   lastModified - whether to send Last-Modified, true by default
+JsFunction::Ptr serveStatic(
+    String::CPtr root,
+    JsObject::CPtr options = JsObject::null());
+
 }  // namespace http
 }  // namespace node
 }  // namespace libj
@@ -0,0 +1,48 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_HTTP_HEADER_BLOCK_H_
+#define LIBNODE_HTTP_HEADER_BLOCK_H_
+
+#include <libj/js_object.h>
+#include <libj/string.h>
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// headers serialized once, e.g. Server, Content-Type or the CORS
+// headers shared by many responses, which ServerResponse::setHeaderBlock
+// splices into the response header as they are.
+// the headers set on the response should not repeat them.
+class HeaderBlock : LIBJ_JS_OBJECT(HeaderBlock)
+ public:
+    // the headers in the block which change how the response is sent
+    enum Special {
+        CONNECTION          = 1 << 0,
+        CONNECTION_CLOSE    = 1 << 1,
+        CONTENT_LENGTH      = 1 << 2,
+        TRANSFER_ENCODING   = 1 << 3,
+        CHUNKED             = 1 << 4,
+        DATE                = 1 << 5,
+        EXPECT              = 1 << 6,
+    };
+
+    // an array value is sent as repeated headers
+    static Ptr create(JsObject::CPtr headers);
+
+    // "Name: value\r\n" for each header
+    virtual String::CPtr serialized() const = 0;
+
+    // serialized() encoded in UTF-8, as it is copied into the header
+    virtual Buffer::CPtr bytes() const = 0;
+
+    virtual UInt specials() const = 0;
+};
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_HTTP_HEADER_BLOCK_H_
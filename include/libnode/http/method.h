@@ -0,0 +1,66 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_HTTP_METHOD_H_
+#define LIBNODE_HTTP_METHOD_H_
+
+#include <libj/symbol.h>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// in the order of http_parser's enum http_method
+#define LIBNODE_HTTP_METHOD_MAP(GEN) \
+    GEN(DELETE, "DELETE") \
+    GEN(GET, "GET") \
+    GEN(HEAD, "HEAD") \
+    GEN(POST, "POST") \
+    GEN(PUT, "PUT") \
+    GEN(CONNECT, "CONNECT") \
+    GEN(OPTIONS, "OPTIONS") \
+    GEN(TRACE, "TRACE") \
+    GEN(COPY, "COPY") \
+    GEN(LOCK, "LOCK") \
+    GEN(MKCOL, "MKCOL") \
+    GEN(MOVE, "MOVE") \
+    GEN(PROPFIND, "PROPFIND") \
+    GEN(PROPPATCH, "PROPPATCH") \
+    GEN(UNLOCK, "UNLOCK") \
+    GEN(REPORT, "REPORT") \
+    GEN(MKACTIVITY, "MKACTIVITY") \
+    GEN(CHECKOUT, "CHECKOUT") \
+    GEN(MERGE, "MERGE") \
+    GEN(MSEARCH, "M-SEARCH") \
+    GEN(NOTIFY, "NOTIFY") \
+    GEN(SUBSCRIBE, "SUBSCRIBE") \
+    GEN(UNSUBSCRIBE, "UNSUBSCRIBE") \
+    GEN(PATCH, "PATCH") \
+    GEN(PURGE, "PURGE")
+
+#define LIBNODE_HTTP_METHOD_GEN(NAME, VAL) \
+    METHOD_##NAME,
+
+enum Method {
+    LIBNODE_HTTP_METHOD_MAP(LIBNODE_HTTP_METHOD_GEN)
+    METHOD_UNKNOWN,
+};
+
+#undef LIBNODE_HTTP_METHOD_GEN
+
+// the name of 'method' as a precomputed symbol
+Symbol::CPtr methodName(Method method);
+
+// METHOD_UNKNOWN if 'name' is not in LIBNODE_HTTP_METHOD_MAP
+Method toMethod(String::CPtr name);
+
+extern Symbol::CPtr HTTP_VERSION_1_0;
+extern Symbol::CPtr HTTP_VERSION_1_1;
+
+// "major.minor", without allocating for HTTP/1.0 and HTTP/1.1
+String::CPtr httpVersion(Int major, Int minor);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_HTTP_METHOD_H_
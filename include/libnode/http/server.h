@@ -17,7 +17,13 @@ class Server : LIBNODE_NET_SERVER(Server)
     static Symbol::CPtr EVENT_UPGRADE;
     static Symbol::CPtr EVENT_CLIENT_ERROR;
 
-    static Ptr create();
+    static Ptr create(JsObject::CPtr options = JsObject::null());
+
+    virtual void closeIdleConnections() = 0;
+
+    // hits, misses, evictions, entries and size (in bytes) of the cache
+    // enabled by the 'responseCacheSize' option, or null without it
+    virtual JsObject::CPtr responseCacheStats() const = 0;
 };
 
 }  // namespace http
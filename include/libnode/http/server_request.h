@@ -3,6 +3,7 @@
 #ifndef LIBNODE_HTTP_SERVER_REQUEST_H_
 #define LIBNODE_HTTP_SERVER_REQUEST_H_
 
+#include "libnode/http/method.h"
 #include "libnode/net/socket.h"
 #include "libnode/stream/readable_stream.h"
 
@@ -13,10 +14,15 @@ namespace http {
 class ServerRequest : LIBNODE_READABLE_STREAM(ServerRequest)
  public:
     virtual String::CPtr method() const = 0;
+    virtual Method methodCode() const = 0;
     virtual String::CPtr url() const = 0;
     virtual JsObject::CPtr headers() const = 0;
+    virtual String::CPtr getHeader(String::CPtr name) const = 0;
     virtual String::CPtr httpVersion() const = 0;
+    virtual Int httpVersionMajor() const = 0;
+    virtual Int httpVersionMinor() const = 0;
     virtual net::Socket::Ptr connection() const = 0;
+    virtual void readBody(Size limit, JsFunction::Ptr callback) = 0;
 };
 
 #define LIBNODE_HTTP_SERVER_REQUEST(T) \
@@ -29,17 +35,32 @@ public: \
     String::CPtr method() const { \
         return SR->method(); \
     } \
+    libj::node::http::Method methodCode() const { \
+        return SR->methodCode(); \
+    } \
     String::CPtr url() const { \
         return SR->url(); \
     } \
     JsObject::CPtr headers() const { \
         return SR->headers(); \
     } \
+    String::CPtr getHeader(String::CPtr name) const { \
+        return SR->getHeader(name); \
+    } \
     String::CPtr httpVersion() const { \
         return SR->httpVersion(); \
     } \
+    Int httpVersionMajor() const { \
+        return SR->httpVersionMajor(); \
+    } \
+    Int httpVersionMinor() const { \
+        return SR->httpVersionMinor(); \
+    } \
     net::Socket::Ptr connection() const { \
         return SR->connection(); \
+    } \
+    void readBody(Size limit, JsFunction::Ptr callback) { \
+        SR->readBody(limit, callback); \
     }
 
 }  // namespace http
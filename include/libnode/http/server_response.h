@@ -3,6 +3,7 @@
 #ifndef LIBNODE_HTTP_SERVER_RESPONSE_H_
 #define LIBNODE_HTTP_SERVER_RESPONSE_H_
 
+#include "libnode/http/header_block.h"
 #include "libnode/stream/writable_stream.h"
 
 namespace libj {
@@ -19,6 +20,12 @@ class ServerResponse : LIBNODE_WRITABLE_STREAM(ServerResponse)
     virtual void setHeader(String::CPtr name, String::CPtr value) = 0;
     virtual String::CPtr getHeader(String::CPtr name) const = 0;
     virtual void removeHeader(String::CPtr name) = 0;
+    virtual Boolean setHeaderBlock(HeaderBlock::CPtr block) = 0;
+    virtual Boolean sendFile(
+        int fd,
+        Size offset,
+        Size length,
+        JsFunction::Ptr callback = JsFunction::null()) = 0;
 };
 
 #define LIBNODE_HTTP_SERVER_RESPONSE(T) \
@@ -45,6 +52,16 @@ public: \
     } \
     virtual void removeHeader(String::CPtr name) { \
         SR->removeHeader(name); \
+    } \
+    virtual Boolean setHeaderBlock(HeaderBlock::CPtr block) { \
+        return SR->setHeaderBlock(block); \
+    } \
+    virtual Boolean sendFile( \
+        int fd, \
+        Size offset, \
+        Size length, \
+        JsFunction::Ptr callback = JsFunction::null()) { \
+        return SR->sendFile(fd, offset, length, callback); \
     }
 
 }  // namespace http
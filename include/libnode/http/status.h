@@ -44,6 +44,7 @@ namespace http {
     GEN(415, UNSUPPORTED_MEDIA_TYPE) \
     GEN(416, REQUESTED_RANGE_NOT_SATISFIABLE) \
     GEN(417, EXPECTATION_FAILED) \
+    GEN(431, REQUEST_HEADER_FIELDS_TOO_LARGE) \
     GEN(500, INTERNAL_SERVER_ERROR) \
     GEN(501, NOT_IMPLEMENTED) \
     GEN(502, BAD_GATEWAY) \
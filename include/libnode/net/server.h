@@ -17,7 +17,7 @@ class Server : LIBNODE_EVENT_EMITTER(Server)
     static Symbol::CPtr EVENT_LISTENING;
     static Symbol::CPtr EVENT_CONNECTION;
 
-    static Ptr create();
+    static Ptr create(JsObject::CPtr options = JsObject::null());
 
     virtual Value address() = 0;
     virtual Boolean listen(
@@ -25,8 +25,15 @@ class Server : LIBNODE_EVENT_EMITTER(Server)
         String::CPtr host = IN_ADDR_ANY,
         Int backlog = 511,
         JsFunction::Ptr callback = JsFunction::null()) = 0;
+    virtual Boolean listen(
+        String::CPtr path,
+        JsFunction::Ptr callback = JsFunction::null()) = 0;
+    virtual Boolean listen(
+        JsObject::CPtr options,
+        JsFunction::Ptr callback = JsFunction::null()) = 0;
     virtual Boolean close(
         JsFunction::Ptr callback = JsFunction::null()) = 0;
+    virtual JsObject::Ptr acceptStats() = 0;
 };
 
 #define LIBNODE_NET_SERVER(T) \
@@ -45,9 +52,22 @@ class Server : LIBNODE_EVENT_EMITTER(Server)
         JsFunction::Ptr callback = JsFunction::null()) { \
         return S->listen(port, host, backlog, callback); \
     } \
+    virtual Boolean listen( \
+        String::CPtr path, \
+        JsFunction::Ptr callback = JsFunction::null()) { \
+        return S->listen(path, callback); \
+    } \
+    virtual Boolean listen( \
+        JsObject::CPtr options, \
+        JsFunction::Ptr callback = JsFunction::null()) { \
+        return S->listen(options, callback); \
+    } \
     virtual Boolean close( \
         JsFunction::Ptr callback = JsFunction::null()) { \
         return S->close(callback); \
+    } \
+    virtual JsObject::Ptr acceptStats() { \
+        return S->acceptStats(); \
     }
 
 }  // namespace net
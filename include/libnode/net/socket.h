@@ -27,6 +27,15 @@ class Socket : LIBNODE_DUPLEX_STREAM(Socket)
     virtual Boolean connect(
         String::CPtr path,
         JsFunction::Ptr callback = JsFunction::null()) = 0;
+    virtual Boolean connect(
+        JsObject::CPtr options,
+        JsFunction::Ptr callback = JsFunction::null()) = 0;
+
+    virtual Boolean sendFile(
+        int fd,
+        Size offset,
+        Size length,
+        JsFunction::Ptr callback = JsFunction::null()) = 0;
 
     virtual Boolean setNoDelay(Boolean noDelay = true) = 0;
     virtual Boolean setKeepAlive(
@@ -52,6 +61,13 @@ public: \
     virtual Int remotePort() { \
         return S->remotePort(); \
     } \
+    virtual Boolean sendFile( \
+        int fd, \
+        Size offset, \
+        Size length, \
+        JsFunction::Ptr callback = JsFunction::null()) { \
+        return S->sendFile(fd, offset, length, callback); \
+    } \
     virtual Boolean setNoDelay(Boolean noDelay = true) { \
         return S->setNoDelay(noDelay); \
     } \
@@ -19,6 +19,11 @@ class DuplexStream : LIBNODE_STREAM(DuplexStream)
     // ReadableStream
     virtual Boolean readable() const = 0;
     virtual Boolean setEncoding(Buffer::Encoding enc) = 0;
+    virtual Boolean pause() = 0;
+    virtual Boolean resume() = 0;
+    virtual Stream::Ptr pipe(
+        Stream::Ptr dest,
+        JsObject::CPtr options = JsObject::null()) = 0;
 
     // WritableStream
     virtual Boolean writable() const = 0;
@@ -43,6 +48,17 @@ public: \
     virtual Boolean setEncoding(Buffer::Encoding enc) { \
         return S->setEncoding(enc); \
     } \
+    virtual Boolean pause() { \
+        return S->pause(); \
+    } \
+    virtual Boolean resume() { \
+        return S->resume(); \
+    } \
+    virtual libj::node::Stream::Ptr pipe( \
+        libj::node::Stream::Ptr dest, \
+        JsObject::CPtr options = JsObject::null()) { \
+        return S->pipe(dest, options); \
+    } \
     virtual Boolean writable() const { \
         return S->writable(); \
     } \
@@ -16,6 +16,11 @@ class ReadableStream : LIBNODE_STREAM(ReadableStream)
 
     virtual Boolean readable() const = 0;
     virtual Boolean setEncoding(Buffer::Encoding enc) = 0;
+    virtual Boolean pause() = 0;
+    virtual Boolean resume() = 0;
+    virtual Stream::Ptr pipe(
+        Stream::Ptr dest,
+        JsObject::CPtr options = JsObject::null()) = 0;
 };
 
 #define LIBNODE_READABLE_STREAM(T) public libj::node::ReadableStream { \
@@ -29,6 +34,17 @@ public: \
     } \
     virtual Boolean setEncoding(Buffer::Encoding enc) { \
         return S->setEncoding(enc); \
+    } \
+    virtual Boolean pause() { \
+        return S->pause(); \
+    } \
+    virtual Boolean resume() { \
+        return S->resume(); \
+    } \
+    virtual libj::node::Stream::Ptr pipe( \
+        libj::node::Stream::Ptr dest, \
+        JsObject::CPtr options = JsObject::null()) { \
+        return S->pipe(dest, options); \
     }
 
 }  // namespace node
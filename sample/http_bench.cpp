@@ -0,0 +1,306 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <libj/status.h>
+#include <libnode/http.h>
+#include <libnode/net.h>
+#include <libnode/node.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <new>
+
+// usage: libnode-http-bench [requests per batch] [batches] [chunks] [scan]
+//
+// sends the requests of each batch in one write, pipelined on one
+// connection, and the next batch when all of them are answered.
+// compare a batch of 1 with a batch of 16 to see the pipelining gain.
+//
+// with 'chunks', each response streams that many 1KiB chunks
+// in chunked encoding instead of a fixed body.
+//
+// with 'scan' of 0 or 1, the requests carry the head of a browser
+// and the server parses them with http_parser or scanRequestHead.
+//
+// the allocations per request count both the server and the client.
+// each run is made twice on the same connection, first with a handler
+// which reads two headers by getHeader and then with one which reads
+// them from headers(), so the cost of building headers() shows as
+// the difference between the two.
+
+static const libj::Int PORT = 10001;
+
+static const char* request =
+    "GET / HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
+static const char* browserRequest =
+    "GET /wiki/Hypertext_Transfer_Protocol HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,*/*;q=0.8\r\n"
+    "Referer: https://en.wikipedia.org/wiki/Main_Page\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,ja;q=0.8\r\n"
+    "Cookie: WMF-Last-Access=18-Oct-2012; "
+    "GeoIP=JP:13:Tokyo:35.69:139.69:v4\r\n"
+    "\r\n";
+
+static libj::Size numAllocs = 0;
+
+#if __cplusplus >= 201103L
+# define HTTP_BENCH_THROW_BAD_ALLOC
+#else
+# define HTTP_BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void* operator new(size_t size) HTTP_BENCH_THROW_BAD_ALLOC {
+    numAllocs++;
+    void* p = malloc(size ? size : 1);
+    if (!p) abort();
+    return p;
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+static double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+namespace libj {
+namespace node {
+
+class OnRequest : LIBJ_JS_FUNCTION(OnRequest)
+ private:
+    Size numChunks_;
+    Buffer::CPtr chunk_;
+    Boolean useHeaders_;
+
+ public:
+    OnRequest(Size numChunks)
+        : numChunks_(numChunks)
+        , chunk_(Buffer::create(1024))
+        , useHeaders_(false) {
+        memset(const_cast<void*>(chunk_->data()), 'x', chunk_->length());
+    }
+
+    Boolean useHeaders() const { return useHeaders_; }
+
+    void setUseHeaders(Boolean useHeaders) { useHeaders_ = useHeaders; }
+
+    Value operator()(JsArray::Ptr args) {
+        http::ServerRequest::Ptr req =
+            toPtr<http::ServerRequest>(args->get(0));
+        http::ServerResponse::Ptr res =
+            toPtr<http::ServerResponse>(args->get(1));
+        if (useHeaders_) {
+            JsObject::CPtr headers = req->headers();
+            headers->get(http::LHEADER_HOST);
+            headers->get(http::LHEADER_USER_AGENT);
+        } else {
+            req->getHeader(http::LHEADER_HOST);
+            req->getHeader(http::LHEADER_USER_AGENT);
+        }
+        res->setHeader(
+            http::HEADER_CONTENT_TYPE,
+            String::create("text/plain"));
+        if (numChunks_) {
+            for (Size i = 0; i < numChunks_; i++) {
+                res->write(chunk_);
+            }
+            res->end();
+        } else {
+            res->setHeader(
+                http::HEADER_CONTENT_LENGTH,
+                String::valueOf(2));
+            res->end(String::create("ok"));
+        }
+        return Status::OK;
+    }
+};
+
+class Client : LIBJ_JS_FUNCTION(Client)
+ private:
+    http::Server::Ptr srv_;
+    OnRequest::Ptr onRequest_;
+    net::Socket::Ptr socket_;
+    String::CPtr batch_;
+    Size batchSize_;
+    Size numBatches_;
+    Size numSent_;
+    Size numReceived_;
+    Size matched_;
+    double start_;
+    Size startAllocs_;
+
+ public:
+    Client(
+        http::Server::Ptr srv,
+        OnRequest::Ptr onRequest,
+        Size batchSize,
+        Size numBatches,
+        Boolean browser)
+        : srv_(srv)
+        , onRequest_(onRequest)
+        , socket_(net::Socket::null())
+        , batch_(String::create())
+        , batchSize_(batchSize)
+        , numBatches_(numBatches)
+        , numSent_(0)
+        , numReceived_(0)
+        , matched_(0)
+        , start_(0)
+        , startAllocs_(0) {
+        String::CPtr req = String::create(
+            browser ? browserRequest : request);
+        for (Size i = 0; i < batchSize_; i++) {
+            batch_ = batch_->concat(req);
+        }
+    }
+
+    void start(net::Socket::Ptr socket) {
+        socket_ = socket;
+        restart();
+    }
+
+    // counts the status lines, which may be split across reads
+    Value operator()(JsArray::Ptr args) {
+        static const char status[] = "HTTP/1.1 200";
+
+        Buffer::CPtr buf = args->getCPtr<Buffer>(0);
+        const char* data = static_cast<const char*>(buf->data());
+        for (Size i = 0; i < buf->length(); i++) {
+            if (data[i] == status[matched_]) {
+                matched_++;
+            } else {
+                matched_ = data[i] == status[0] ? 1 : 0;
+            }
+            if (matched_ == sizeof(status) - 1) {
+                matched_ = 0;
+                numReceived_++;
+            }
+        }
+
+        if (numReceived_ < numSent_) return Status::OK;
+
+        if (numSent_ < batchSize_ * numBatches_) {
+            send();
+        } else {
+            double elapsed = now() - start_;
+            Size allocs = numAllocs - startAllocs_;
+            ::printf(
+                "%s: %d requests, %d per batch: %.0f req/s, "
+                "%.1f allocations/req\n",
+                onRequest_->useHeaders() ? "headers()" : "getHeader",
+                static_cast<int>(numReceived_),
+                static_cast<int>(batchSize_),
+                numReceived_ / elapsed,
+                static_cast<double>(allocs) / numReceived_);
+            if (onRequest_->useHeaders()) {
+                socket_->destroy();
+                srv_->close();
+            } else {
+                onRequest_->setUseHeaders(true);
+                restart();
+            }
+        }
+        return Status::OK;
+    }
+
+ private:
+    void restart() {
+        numSent_ = 0;
+        numReceived_ = 0;
+        start_ = now();
+        startAllocs_ = numAllocs;
+        send();
+    }
+
+    void send() {
+        socket_->write(batch_);
+        numSent_ += batchSize_;
+    }
+};
+
+class OnConnect : LIBJ_JS_FUNCTION(OnConnect)
+ private:
+    Client::Ptr client_;
+
+ public:
+    OnConnect(Client::Ptr client) : client_(client) {}
+
+    Value operator()(JsArray::Ptr args) {
+        net::Socket::Ptr socket = net::createConnection(PORT);
+        socket->on(net::Socket::EVENT_DATA, client_);
+        socket->on(
+            net::Socket::EVENT_CONNECT,
+            OnStart::create(client_, socket));
+        return Status::OK;
+    }
+
+ private:
+    class OnStart : LIBJ_JS_FUNCTION(OnStart)
+     public:
+        static Ptr create(Client::Ptr client, net::Socket::Ptr socket) {
+            return Ptr(new OnStart(client, socket));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            client_->start(socket_);
+            return Status::OK;
+        }
+
+     private:
+        Client::Ptr client_;
+        net::Socket::Ptr socket_;
+
+        OnStart(Client::Ptr client, net::Socket::Ptr socket)
+            : client_(client)
+            , socket_(socket) {}
+    };
+};
+
+}  // namespace node
+}  // namespace libj
+
+int main(int argc, char** argv) {
+    namespace node = libj::node;
+    namespace http = libj::node::http;
+
+    libj::Size batchSize = argc > 1 ? atoi(argv[1]) : 16;
+    libj::Size numBatches = argc > 2 ? atoi(argv[2]) : 10000;
+    libj::Size numChunks = argc > 3 ? atoi(argv[3]) : 0;
+    libj::Int scan = argc > 4 ? atoi(argv[4]) : -1;
+    if (!batchSize) batchSize = 1;
+
+    libj::JsObject::Ptr options = libj::JsObject::create();
+    options->put(libj::String::create("fastScan"), scan > 0);
+    if (scan >= 0) {
+        ::printf("%s\n", scan ? "scanRequestHead" : "http_parser");
+    }
+
+    http::Server::Ptr server = http::Server::create(options);
+    node::OnRequest::Ptr onRequest(new node::OnRequest(numChunks));
+    server->on(http::Server::EVENT_REQUEST, onRequest);
+
+    node::Client::Ptr client(new node::Client(
+        server, onRequest, batchSize, numBatches, scan >= 0));
+    server->listen(
+        PORT,
+        http::Server::IN_ADDR_ANY,
+        511,
+        node::OnConnect::Ptr(new node::OnConnect(client)));
+    node::run();
+    return 0;
+}
@@ -1,67 +1,13 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
-#include <libj/status.h>
-#include <libnode/fs.h>
 #include <libnode/http.h>
 #include <libnode/node.h>
-#include <libnode/url.h>
-
-static libj::String::CPtr root;
-
-namespace libj {
-namespace node {
-
-class OnRead : LIBJ_JS_FUNCTION(OnRead)
- private:
-    http::ServerResponse::Ptr res_;
-
- public:
-    OnRead(http::ServerResponse::Ptr res) : res_(res) {}
-
-    Value operator()(JsArray::Ptr args) {
-        Buffer::CPtr content = toCPtr<Buffer>(args->get(1));
-        res_->setHeader(
-            http::HEADER_CONTENT_TYPE,
-            String::create("text/plain"));
-        if (content) {
-            res_->setHeader(
-                http::HEADER_CONTENT_LENGTH,
-                String::valueOf(content->length()));
-            res_->write(content);
-        } else {
-            http::Status::CPtr status404 =
-                http::Status::create(http::Status::NOT_FOUND);
-            res_->writeHead(status404->code());
-            res_->write(status404->message());
-        }
-        res_->end();
-        return Status::OK;
-    }
-};
-
-class OnRequest : LIBJ_JS_FUNCTION(OnRequest)
- public:
-    Value operator()(JsArray::Ptr args) {
-        http::ServerRequest::Ptr req =
-            toPtr<http::ServerRequest>(args->get(0));
-        http::ServerResponse::Ptr res =
-            toPtr<http::ServerResponse>(args->get(1));
-        JsObject::Ptr url = url::parse(req->url());
-        OnRead::Ptr onRead(new OnRead(res));
-        fs::readFile(
-            root->concat(toCPtr<String>(url->get(url::PATHNAME))),
-            onRead);
-        return Status::OK;
-    }
-};
-
-}  // namespace node
-}  // namespace libj
 
 int main(int argc, char *argv[]) {
     namespace node = libj::node;
     namespace http = libj::node::http;
 
+    libj::String::CPtr root;
     if (argc < 2) {
         char dir[256];
         getcwd(dir, 256);
@@ -70,8 +16,11 @@ int main(int argc, char *argv[]) {
         root = libj::String::create(argv[1]);
     }
 
-    node::OnRequest::Ptr requestHandler(new node::OnRequest());
-    http::Server::Ptr server = http::createServer(requestHandler);
+    libj::JsObject::Ptr options = libj::JsObject::create();
+    options->put(libj::String::create("maxAge"), 60);
+
+    http::Server::Ptr server = http::createServer(
+        http::serveStatic(root, options));
     server->listen(10000);
     node::run();
     return 0;
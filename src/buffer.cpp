@@ -1,6 +1,7 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
 #include <assert.h>
+#include <string.h>
 #include <string>
 
 #include "libnode/buffer.h"
@@ -19,9 +20,9 @@ class BufferImpl : public Buffer {
         if (!data) return null();
 
         BufferImpl* buf(new BufferImpl(length));
-        const UByte* d = static_cast<const UByte*>(data);
-        for (Size i = 0; i < length; i++)
-            buf->setUInt8(i, d[i]);
+        if (length) {
+            memcpy(const_cast<void*>(buf->data()), data, length);
+        }
         return Ptr(buf);
     }
 
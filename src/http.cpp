@@ -7,7 +7,13 @@ namespace node {
 namespace http {
 
 Server::Ptr createServer(JsFunction::Ptr requestListener) {
-    Server::Ptr srv = Server::create();
+    return createServer(JsObject::null(), requestListener);
+}
+
+Server::Ptr createServer(
+    JsObject::CPtr options,
+    JsFunction::Ptr requestListener) {
+    Server::Ptr srv = Server::create(options);
     if (requestListener) {
         srv->on(Server::EVENT_REQUEST, requestListener);
     }
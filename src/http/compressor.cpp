@@ -0,0 +1,184 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libj/symbol.h>
+
+#include <vector>
+
+#include "./compressor.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+static const Int kNumLevels = 10;
+static const Size kMaxPooled = 16;
+
+static std::vector<Compressor*> pools[Compressor::DEFLATE + 1][kNumLevels];
+
+static Int normalizeLevel(Int level) {
+    if (level < 0) {
+        return 6;  // Z_DEFAULT_COMPRESSION
+    } else if (level >= kNumLevels) {
+        return kNumLevels - 1;
+    } else {
+        return level;
+    }
+}
+
+Compressor::Compressor(Encoding enc, Int level)
+    : encoding_(enc)
+    , level_(level) {
+    memset(&stream_, 0, sizeof(stream_));
+}
+
+Compressor::~Compressor() {
+    deflateEnd(&stream_);
+}
+
+Compressor* Compressor::acquire(Encoding enc, Int level) {
+    if (enc != GZIP && enc != DEFLATE) return NULL;
+
+    level = normalizeLevel(level);
+    std::vector<Compressor*>& pool = pools[enc][level];
+    if (!pool.empty()) {
+        Compressor* compressor = pool.back();
+        pool.pop_back();
+        return compressor;
+    }
+
+    Compressor* compressor = new Compressor(enc, level);
+    // 16 more bits of the window size ask zlib for a gzip wrapper
+    int windowBits = enc == GZIP ? 15 + 16 : 15;
+    int r = deflateInit2(
+        &compressor->stream_,
+        level,
+        Z_DEFLATED,
+        windowBits,
+        8,
+        Z_DEFAULT_STRATEGY);
+    if (r != Z_OK) {
+        delete compressor;
+        return NULL;
+    }
+    return compressor;
+}
+
+void Compressor::release(Compressor* compressor) {
+    if (!compressor) return;
+
+    std::vector<Compressor*>& pool =
+        pools[compressor->encoding_][compressor->level_];
+    if (pool.size() < kMaxPooled &&
+        deflateReset(&compressor->stream_) == Z_OK) {
+        pool.push_back(compressor);
+    } else {
+        delete compressor;
+    }
+}
+
+Boolean Compressor::deflate(
+    const void* data,
+    Size len,
+    int flush,
+    std::string* out) {
+    assert(out);
+
+    char buf[16 * 1024];
+    stream_.next_in = static_cast<Bytef*>(const_cast<void*>(data));
+    stream_.avail_in = len;
+    do {
+        stream_.next_out = reinterpret_cast<Bytef*>(buf);
+        stream_.avail_out = sizeof(buf);
+        if (::deflate(&stream_, flush) == Z_STREAM_ERROR) return false;
+
+        out->append(buf, sizeof(buf) - stream_.avail_out);
+    } while (!stream_.avail_out);
+    return true;
+}
+
+// the quality of the coding, 1 if no 'q' parameter is given
+static double quality(const std::string& params) {
+    Size pos = params.find("q=");
+    if (pos == std::string::npos) return 1;
+
+    return atof(params.c_str() + pos + 2);
+}
+
+Compressor::Encoding Compressor::negotiate(String::CPtr acceptEncoding) {
+    if (!acceptEncoding) return NONE;
+
+    std::string ae = acceptEncoding->toLowerCase()->toStdString();
+    double gzip = -1;
+    double deflate = -1;
+    double any = -1;
+    Size start = 0;
+    while (start < ae.length()) {
+        Size end = ae.find(',', start);
+        if (end == std::string::npos) end = ae.length();
+
+        Size semi = ae.find(';', start);
+        if (semi > end) semi = end;
+
+        std::string coding;
+        for (Size i = start; i < semi; i++) {
+            if (!isspace(static_cast<unsigned char>(ae[i]))) {
+                coding += ae[i];
+            }
+        }
+        double q = quality(ae.substr(semi, end - semi));
+        if (coding == "gzip" || coding == "x-gzip") {
+            gzip = q;
+        } else if (coding == "deflate") {
+            deflate = q;
+        } else if (coding == "*") {
+            any = q;
+        }
+        start = end + 1;
+    }
+
+    if (gzip < 0) gzip = any;
+    if (deflate < 0) deflate = any;
+    if (gzip <= 0 && deflate <= 0) {
+        return NONE;
+    } else if (gzip >= deflate) {
+        return GZIP;
+    } else {
+        return DEFLATE;
+    }
+}
+
+String::CPtr Compressor::name(Encoding enc) {
+    LIBJ_STATIC_SYMBOL_DEF(symGzip,     "gzip");
+    LIBJ_STATIC_SYMBOL_DEF(symDeflate,  "deflate");
+    LIBJ_STATIC_SYMBOL_DEF(symIdentity, "identity");
+
+    switch (enc) {
+    case GZIP:
+        return symGzip;
+    case DEFLATE:
+        return symDeflate;
+    default:
+        return symIdentity;
+    }
+}
+
+Boolean Compressor::compressible(String::CPtr contentType) {
+    if (!contentType) return false;
+
+    std::string type = contentType->toLowerCase()->toStdString();
+    Size semi = type.find(';');
+    if (semi != std::string::npos) type.erase(semi);
+
+    return type.compare(0, 5, "text/") == 0 ||
+        type.find("json") != std::string::npos ||
+        type.find("javascript") != std::string::npos ||
+        type.find("xml") != std::string::npos;
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,68 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_COMPRESSOR_H_
+#define LIBNODE_SRC_HTTP_COMPRESSOR_H_
+
+#include <zlib.h>
+#include <libj/string.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// a zlib deflate stream which compresses a response body.
+// deflateInit2 allocates a few hundred KiB each time, so the streams
+// are pooled by encoding and level, and reset when they are released.
+class Compressor {
+ public:
+    enum Encoding {
+        NONE,
+        GZIP,
+        DEFLATE,
+    };
+
+    // the level is clamped to 0 (none) .. 9 (best),
+    // and any other negative value is zlib's default
+    static Compressor* acquire(Encoding enc, Int level);
+
+    static void release(Compressor* compressor);
+
+    // 'gzip', 'deflate' or 'identity', which 'acceptEncoding' prefers.
+    // gzip is chosen over deflate at the same quality.
+    static Encoding negotiate(String::CPtr acceptEncoding);
+
+    static String::CPtr name(Encoding enc);
+
+    // whether a body of 'contentType' is worth compressing
+    static Boolean compressible(String::CPtr contentType);
+
+    // appends the compressed bytes of 'data' to 'out'.
+    // 'flush' is Z_NO_FLUSH, Z_SYNC_FLUSH or Z_FINISH.
+    // it touches nothing but the zlib stream,
+    // so that it can be called in the libuv threadpool.
+    Boolean deflate(const void* data, Size len, int flush, std::string* out);
+
+    Encoding encoding() const {
+        return encoding_;
+    }
+
+    Int level() const {
+        return level_;
+    }
+
+ private:
+    Encoding encoding_;
+    Int level_;
+    z_stream stream_;
+
+    Compressor(Encoding enc, Int level);
+    ~Compressor();
+};
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_COMPRESSOR_H_
@@ -0,0 +1,115 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "./date_cache.h"
+#include "../uv/timer.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+static std::string cachedLine;
+
+class DateCacheOnTimeout : LIBJ_JS_FUNCTION(DateCacheOnTimeout)
+ public:
+    Value operator()(JsArray::Ptr args) {
+        cachedLine.clear();
+        return libj::Status::OK;
+    }
+};
+
+static const char* kDays[] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+};
+
+static const char* kMonths[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+// IMF-fixdate, without depending on the locale as strftime does
+std::string httpDate(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+
+    char buf[32];
+    int len = snprintf(
+        buf,
+        sizeof(buf),
+        "%s, %02d %s %04d %02d:%02d:%02d GMT",
+        kDays[tm.tm_wday],
+        tm.tm_mday,
+        kMonths[tm.tm_mon],
+        tm.tm_year + 1900,
+        tm.tm_hour,
+        tm.tm_min,
+        tm.tm_sec);
+    return std::string(buf, len);
+}
+
+Boolean parseHttpDate(const std::string& date, time_t* t) {
+    if (!t) return false;
+
+    char day[4];
+    char month[4];
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    int n = sscanf(
+        date.c_str(),
+        "%3s, %d %3s %d %d:%d:%d GMT",
+        day,
+        &tm.tm_mday,
+        month,
+        &tm.tm_year,
+        &tm.tm_hour,
+        &tm.tm_min,
+        &tm.tm_sec);
+    if (n != 7) return false;
+
+    tm.tm_mon = -1;
+    for (int i = 0; i < 12; i++) {
+        if (!strcmp(month, kMonths[i])) {
+            tm.tm_mon = i;
+            break;
+        }
+    }
+    if (tm.tm_mon < 0 ||
+        tm.tm_mday < 1 || tm.tm_mday > 31 ||
+        tm.tm_hour > 23 || tm.tm_min > 59 || tm.tm_sec > 60) {
+        return false;
+    }
+
+    tm.tm_year -= 1900;
+    *t = timegm(&tm);
+    return *t != static_cast<time_t>(-1);
+}
+
+const std::string& dateHeaderLine() {
+    static uv::Timer* timer = NULL;
+
+    if (!cachedLine.empty()) return cachedLine;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    cachedLine = "Date: ";
+    cachedLine += httpDate(tv.tv_sec);
+    cachedLine += "\r\n";
+
+    if (!timer) {
+        timer = new uv::Timer();
+        timer->setOnTimeout(
+            DateCacheOnTimeout::Ptr(new DateCacheOnTimeout()));
+        timer->unref();
+    }
+    // until the next second begins
+    timer->start(1000 - tv.tv_usec / 1000, 0);
+    return cachedLine;
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
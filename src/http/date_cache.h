@@ -0,0 +1,31 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_DATE_CACHE_H_
+#define LIBNODE_SRC_HTTP_DATE_CACHE_H_
+
+#include <time.h>
+#include <libj/string.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n" for the current second.
+// it is formatted at most once a second, and an unref'd timer drops
+// it when the second is over.
+const std::string& dateHeaderLine();
+
+// "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string httpDate(time_t t);
+
+// only IMF-fixdate is accepted, which every HTTP/1.1 client sends.
+// false if 'date' is in any other format.
+Boolean parseHttpDate(const std::string& date, time_t* t);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_DATE_CACHE_H_
@@ -1,7 +1,11 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <assert.h>
+
 #include "libnode/http/header.h"
 
+#include "./known_header.h"
+
 namespace libj {
 namespace node {
 namespace http {
@@ -18,6 +22,128 @@ LIBNODE_HTTP_HEADER_MAP(
 LIBNODE_HTTP_HEADER_MAP(
     LIBNODE_HTTP_LHEADER_DEF_GEN)
 
+#define LIBNODE_HTTP_HEADER_NAME_GEN(NAME, VAL) \
+    VAL,
+
+#define LIBNODE_HTTP_LHEADER_PTR_GEN(NAME, VAL) \
+    &L##NAME,
+
+static const char* knownHeaderNames[] = {
+    LIBNODE_HTTP_HEADER_MAP(LIBNODE_HTTP_HEADER_NAME_GEN)
+};
+
+static Symbol::CPtr* knownHeaderSymbols[] = {
+    LIBNODE_HTTP_HEADER_MAP(LIBNODE_HTTP_LHEADER_PTR_GEN)
+};
+
+// FNV-1a over the lower-cased bytes. the seed is chosen so that
+// every name in LIBNODE_HTTP_HEADER_MAP gets a slot of its own.
+static const UInt KNOWN_HEADER_SEED = 0x811ccb41;
+static const Size KNOWN_HEADER_SLOTS = 256;
+
+static inline UInt toLower(UInt c) {
+    return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+static inline Size knownHeaderSlot(UInt hash) {
+    return (hash ^ (hash >> 16)) & (KNOWN_HEADER_SLOTS - 1);
+}
+
+static inline UInt knownHeaderHash(UInt hash, UInt c) {
+    return (hash ^ (c | 0x20)) * 16777619;
+}
+
+static const signed char* knownHeaderTable() {
+    static signed char table[KNOWN_HEADER_SLOTS];
+    static Boolean initTable = false;
+    if (!initTable) {
+        for (Size i = 0; i < KNOWN_HEADER_SLOTS; i++) {
+            table[i] = KNOWN_HEADER_NONE;
+        }
+        for (Size i = 0; i < NUM_KNOWN_HEADERS; i++) {
+            UInt hash = KNOWN_HEADER_SEED;
+            for (const char* p = knownHeaderNames[i]; *p; p++) {
+                hash = knownHeaderHash(hash, static_cast<UInt>(*p));
+            }
+            Size slot = knownHeaderSlot(hash);
+            assert(table[slot] == KNOWN_HEADER_NONE);
+            table[slot] = static_cast<signed char>(i);
+        }
+        initTable = true;
+    }
+    return table;
+}
+
+KnownHeader knownHeader(const char* name, Size len) {
+    if (!name || !len) return KNOWN_HEADER_NONE;
+
+    UInt hash = KNOWN_HEADER_SEED;
+    for (Size i = 0; i < len; i++) {
+        hash = knownHeaderHash(hash, static_cast<unsigned char>(name[i]));
+    }
+    Int i = knownHeaderTable()[knownHeaderSlot(hash)];
+    if (i == KNOWN_HEADER_NONE) return KNOWN_HEADER_NONE;
+
+    const char* known = knownHeaderNames[i];
+    for (Size j = 0; j < len; j++) {
+        if (!known[j] ||
+            toLower(static_cast<unsigned char>(name[j])) !=
+            toLower(static_cast<unsigned char>(known[j]))) {
+            return KNOWN_HEADER_NONE;
+        }
+    }
+    return known[len] ? KNOWN_HEADER_NONE : static_cast<KnownHeader>(i);
+}
+
+KnownHeader knownHeader(String::CPtr name) {
+    if (!name) return KNOWN_HEADER_NONE;
+
+    Size len = name->length();
+    UInt hash = KNOWN_HEADER_SEED;
+    for (Size i = 0; i < len; i++) {
+        Char c = name->charAt(i);
+        if (c > 0x7f) return KNOWN_HEADER_NONE;
+        hash = knownHeaderHash(hash, static_cast<UInt>(c));
+    }
+    Int i = knownHeaderTable()[knownHeaderSlot(hash)];
+    if (i == KNOWN_HEADER_NONE) return KNOWN_HEADER_NONE;
+
+    const char* known = knownHeaderNames[i];
+    for (Size j = 0; j < len; j++) {
+        if (!known[j] ||
+            toLower(static_cast<UInt>(name->charAt(j))) !=
+            toLower(static_cast<unsigned char>(known[j]))) {
+            return KNOWN_HEADER_NONE;
+        }
+    }
+    return known[len] ? KNOWN_HEADER_NONE : static_cast<KnownHeader>(i);
+}
+
+Symbol::CPtr knownHeaderName(KnownHeader header) {
+    assert(header > KNOWN_HEADER_NONE && header < NUM_KNOWN_HEADERS);
+    return *knownHeaderSymbols[header];
+}
+
+Boolean isCommaSeparated(KnownHeader header) {
+    switch (header) {
+    case KNOWN_HEADER_ACCEPT:
+    case KNOWN_HEADER_ACCEPT_CHARSET:
+    case KNOWN_HEADER_ACCEPT_ENCODING:
+    case KNOWN_HEADER_ACCEPT_LANGUAGE:
+    case KNOWN_HEADER_CONNECTION:
+    case KNOWN_HEADER_COOKIE:
+    case KNOWN_HEADER_PRAGMA:
+    case KNOWN_HEADER_LINK:
+    case KNOWN_HEADER_WWW_AUTHENTICATE:
+    case KNOWN_HEADER_PROXY_AUTHENTICATE:
+    case KNOWN_HEADER_SEC_WEBSOCKET_EXTENSIONS:
+    case KNOWN_HEADER_SEC_WEBSOCKET_PROTOCOL:
+        return true;
+    default:
+        return false;
+    }
+}
+
 }  // namespace http
 }  // namespace node
 }  // namespace libj
@@ -0,0 +1,112 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <assert.h>
+#include <libj/js_array.h>
+#include <libj/string_buffer.h>
+
+#include "libnode/http/header_block.h"
+
+#include "./known_header.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+class HeaderBlockImpl : public HeaderBlock {
+ public:
+    static Ptr create(JsObject::CPtr headers) {
+        HeaderBlockImpl* block = new HeaderBlockImpl();
+        if (headers) {
+            StringBuffer::Ptr sb = StringBuffer::create();
+            Set::CPtr keys = headers->keySet();
+            Iterator::Ptr itr = keys->iterator();
+            while (itr->hasNext()) {
+                String::CPtr name = toCPtr<String>(itr->next());
+                assert(name);
+                Value value = headers->get(name);
+                block->obj_->put(name, value);
+
+                JsArray::CPtr ary = toCPtr<JsArray>(value);
+                if (ary) {
+                    Size len = ary->length();
+                    for (Size i = 0; i < len; i++) {
+                        block->add(sb, name, ary->get(i));
+                    }
+                } else {
+                    block->add(sb, name, value);
+                }
+            }
+            block->serialized_ = sb->toString();
+            block->bytes_ = Buffer::create(block->serialized_);
+        }
+        return Ptr(block);
+    }
+
+    virtual String::CPtr serialized() const {
+        return serialized_;
+    }
+
+    virtual Buffer::CPtr bytes() const {
+        return bytes_;
+    }
+
+    virtual UInt specials() const {
+        return specials_;
+    }
+
+ private:
+    void add(StringBuffer::Ptr sb, String::CPtr name, const Value& value) {
+        LIBJ_STATIC_SYMBOL_DEF(symClose,   "close");
+        LIBJ_STATIC_SYMBOL_DEF(symChunked, "chunked");
+
+        String::CPtr str = String::valueOf(value);
+        sb->append(name);
+        sb->appendCStr(": ");
+        sb->append(str);
+        sb->appendCStr("\r\n");
+
+        switch (knownHeader(name)) {
+        case KNOWN_HEADER_CONNECTION:
+            specials_ |= CONNECTION;
+            if (str->equals(symClose)) specials_ |= CONNECTION_CLOSE;
+            break;
+        case KNOWN_HEADER_CONTENT_LENGTH:
+            specials_ |= CONTENT_LENGTH;
+            break;
+        case KNOWN_HEADER_TRANSFER_ENCODING:
+            specials_ |= TRANSFER_ENCODING;
+            if (str->equals(symChunked)) specials_ |= CHUNKED;
+            break;
+        case KNOWN_HEADER_DATE:
+            specials_ |= DATE;
+            break;
+        case KNOWN_HEADER_EXPECT:
+            specials_ |= EXPECT;
+            break;
+        default:
+            break;
+        }
+    }
+
+ private:
+    JsObject::Ptr obj_;
+    String::CPtr serialized_;
+    Buffer::CPtr bytes_;
+    UInt specials_;
+
+    HeaderBlockImpl()
+        : obj_(JsObject::create())
+        , serialized_(String::create())
+        , bytes_(Buffer::create())
+        , specials_(0) {}
+
+    LIBJ_JS_OBJECT_IMPL(obj_);
+};
+
+HeaderBlock::Ptr HeaderBlock::create(JsObject::CPtr headers) {
+    return HeaderBlockImpl::create(headers);
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,84 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_HEADER_BUFFER_H_
+#define LIBNODE_SRC_HTTP_HEADER_BUFFER_H_
+
+#include <stdio.h>
+#include <libj/string.h>
+
+#include <string>
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// builds a message header directly in UTF-8 bytes,
+// which are copied into a Buffer once it is complete
+class HeaderBuffer {
+ public:
+    HeaderBuffer() {
+        bytes_.reserve(kInitialCapacity);
+    }
+
+    void append(const char* cstr) {
+        bytes_.append(cstr);
+    }
+
+    void append(const void* data, Size len) {
+        bytes_.append(static_cast<const char*>(data), len);
+    }
+
+    void append(const std::string& str) {
+        bytes_.append(str);
+    }
+
+    // header names and values are mostly ASCII,
+    // which are copied without converting the whole string
+    void append(String::CPtr str) {
+        if (!str) return;
+
+        Size len = str->length();
+        Size start = bytes_.length();
+        bytes_.resize(start + len);
+        for (Size i = 0; i < len; i++) {
+            Char c = str->charAt(i);
+            if (c & ~0x7f) {
+                bytes_.resize(start);
+                bytes_.append(str->toStdString());
+                return;
+            }
+            bytes_[start + i] = static_cast<char>(c);
+        }
+    }
+
+    void appendDecimal(Size n) {
+        char s[24];
+        int len = snprintf(s, sizeof(s), "%zu", n);
+        bytes_.append(s, len);
+    }
+
+    Size length() const {
+        return bytes_.length();
+    }
+
+    const std::string& bytes() const {
+        return bytes_;
+    }
+
+    Buffer::Ptr toBuffer() const {
+        return Buffer::create(bytes_.data(), bytes_.length());
+    }
+
+ private:
+    static const Size kInitialCapacity = 512;
+
+    std::string bytes_;
+};
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_HEADER_BUFFER_H_
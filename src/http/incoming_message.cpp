@@ -0,0 +1,22 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "./incoming_message.h"
+#include "./parser.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+void IncomingMessage::resumeSocket() {
+    if (!hasFlag(SOCKET_PAUSED)) return;
+
+    unsetFlag(SOCKET_PAUSED);
+    Parser* parser = socket_->parser();
+    if (parser && parser->paused()) return;
+
+    if (socket_->readable()) socket_->resume();
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -4,15 +4,22 @@
 #define LIBNODE_SRC_HTTP_INCOMING_MESSAGE_H_
 
 #include <assert.h>
+#include <string.h>
 #include <libj/linked_list.h>
 
+#include <vector>
+
 #include "libnode/http/header.h"
+#include "libnode/http/method.h"
+#include "libnode/http/status.h"
 #include "libnode/process.h"
 #include "libnode/stream/readable_stream.h"
 #include "libnode/string_decoder.h"
 
 #include "../flag.h"
 #include "../net/socket_impl.h"
+#include "../stream/pipe.h"
+#include "./known_header.h"
 
 namespace libj {
 namespace node {
@@ -46,7 +53,20 @@ class IncomingMessage
         return httpVersion_;
     }
 
+    // built on the first call from the raw header lines
     JsObject::CPtr headers() const {
+        if (!headers_) {
+            headers_ = JsObject::create();
+            for (Size i = 0; i < lines_.size(); i++) {
+                const HeaderLine& line = lines_[i];
+                if (!line.value) continue;
+
+                String::CPtr field = line.header != KNOWN_HEADER_NONE
+                    ? knownHeaderName(line.header)
+                    : line.name->toLowerCase();
+                putHeaderLine(headers_, line.header, field, line.value);
+            }
+        }
         return headers_;
     }
 
@@ -58,6 +78,18 @@ class IncomingMessage
         return method_;
     }
 
+    Method methodCode() const {
+        return methodCode_;
+    }
+
+    Int httpVersionMajor() const {
+        return httpVersionMajor_;
+    }
+
+    Int httpVersionMinor() const {
+        return httpVersionMinor_;
+    }
+
     Boolean readable() const {
         return hasFlag(READABLE);
     }
@@ -70,70 +102,153 @@ class IncomingMessage
         return !!decoder_;
     }
 
+    // the body is buffered until highWaterMark bytes are pending,
+    // then the socket stops reading until they drain to lowWaterMark
+    Boolean pause() {
+        setFlag(PAUSED);
+        if (pendingBytes_ >= highWaterMark_) pauseSocket();
+        return true;
+    }
+
+    Boolean resume() {
+        unsetFlag(PAUSED);
+        resumeSocketIfDrained();
+        emitPending();
+        return true;
+    }
+
+    Stream::Ptr pipe(
+        Stream::Ptr dest,
+        JsObject::CPtr options = JsObject::null()) {
+        return stream::pipe(this, dest, options);
+    }
+
+    // collect the body into one Buffer, preallocated from Content-Length,
+    // and call back (err, body). no more than 'limit' bytes are buffered;
+    // a larger body is discarded and answered with 413.
+    void readBody(Size limit, JsFunction::Ptr callback) {
+        if (hasFlag(READING_BODY) || hasFlag(END_EMITTED)) {
+            if (callback) {
+                callback->call(
+                    libj::Error::create(libj::Error::ILLEGAL_STATE));
+            }
+            return;
+        }
+
+        setFlag(READING_BODY);
+        bodyLimit_ = limit ? limit : maxBodySize_;
+        onReadBody_ = callback;
+
+        Size length = contentLength();
+        if (length == NO_SIZE) {
+            bodyChunks_ = JsArray::create();
+        } else if (length > bodyLimit_) {
+            bodyTooLarge();
+            return;
+        } else {
+            body_ = Buffer::create(length);
+        }
+
+        // chunks which arrived before this call
+        while (!pendings_->isEmpty()) {
+            Buffer::CPtr chunk = shiftPending();
+            if (chunk) {
+                appendBody(
+                    static_cast<const char*>(chunk->data()),
+                    chunk->length());
+            }
+        }
+        if (hasFlag(COMPLETE)) {
+            finishBody();
+        } else {
+            unsetFlag(PAUSED);
+            resumeSocket();
+        }
+    }
+
  public:
     void setStatusCode(Int statusCode) {
         statusCode_ = statusCode;
     }
 
-    void setHttpVersion(String::CPtr httpVersion) {
-        httpVersion_ = httpVersion;
+    void setHttpVersion(Int major, Int minor) {
+        httpVersionMajor_ = major;
+        httpVersionMinor_ = minor;
+        httpVersion_ = httpVersion(major, minor);
     }
 
+    // looks into the raw header lines without building headers()
     String::CPtr getHeader(String::CPtr name) const {
-        return headers_->getCPtr<String>(name);
+        if (!name) return String::null();
+
+        KnownHeader header = knownHeader(name);
+        if (header == KNOWN_HEADER_SET_COOKIE) {
+            // an array in headers()
+            return String::null();
+        } else if (header != KNOWN_HEADER_NONE) {
+            Boolean join = isCommaSeparated(header);
+            String::CPtr value = String::null();
+            for (Int i = known_[header]; i >= 0; i = lines_[i].next) {
+                value = mergeValue(value, lines_[i].value, join);
+            }
+            return value;
+        } else {
+            Boolean join = isExtension(name);
+            String::CPtr value = String::null();
+            for (Size i = 0; i < lines_.size(); i++) {
+                const HeaderLine& line = lines_[i];
+                if (line.header == KNOWN_HEADER_NONE &&
+                    line.value &&
+                    equalsIgnoreCase(line.name, name)) {
+                    value = mergeValue(value, line.value, join);
+                }
+            }
+            return value;
+        }
     }
 
     void setHeader(String::CPtr name, String::CPtr value) {
-        headers_->put(name->toLowerCase(), value);
-    }
-
-    void addHeaderLine(String::CPtr name, String::CPtr value) {
-        LIBJ_STATIC_SYMBOL_DEF(symExtPrefix, "x-");
-        static Set::Ptr commaSeparated = Set::null();
-
         assert(name && value);
 
-        if (!commaSeparated) {
-            commaSeparated = Set::create();
-            commaSeparated->add(LHEADER_ACCEPT);
-            commaSeparated->add(LHEADER_ACCEPT_CHARSET);
-            commaSeparated->add(LHEADER_ACCEPT_ENCODING);
-            commaSeparated->add(LHEADER_ACCEPT_LANGUAGE);
-            commaSeparated->add(LHEADER_CONNECTION);
-            commaSeparated->add(LHEADER_COOKIE);
-            commaSeparated->add(LHEADER_PRAGMA);
-            commaSeparated->add(LHEADER_LINK);
-            commaSeparated->add(LHEADER_WWW_AUTHENTICATE);
-            commaSeparated->add(LHEADER_PROXY_AUTHENTICATE);
-            commaSeparated->add(LHEADER_SEC_WEBSOCKET_EXTENSIONS);
-            commaSeparated->add(LHEADER_SEC_WEBSOCKET_PROTOCOL);
-        }
-
-        JsObject::Ptr dest = hasFlag(COMPLETE) ? trailers_ : headers_;
-        String::CPtr field = name->toLowerCase();
-        if (field->equals(LHEADER_SET_COOKIE)) {
-            JsArray::Ptr vals = headers_->getPtr<JsArray>(field);
-            if (vals) {
-                vals->add(value);
-            } else {
-                JsArray::Ptr vals = JsArray::create();
-                vals->add(value);
-                dest->put(field, vals);
+        KnownHeader header = knownHeader(name);
+        if (header != KNOWN_HEADER_NONE) {
+            for (Int i = known_[header]; i >= 0; i = lines_[i].next) {
+                lines_[i].value = String::null();
             }
-        } else if (commaSeparated->contains(field) ||
-                   field->startsWith(symExtPrefix)) {
-            String::CPtr vals = headers_->getCPtr<String>(field);
-            if (vals) {
-                StringBuffer::Ptr sb = StringBuffer::create();
-                sb->append(vals);
-                sb->appendCStr(", ");
-                sb->append(value);
-                dest->put(field, sb->toString());
-            } else {
-                dest->put(field, value);
+            known_[header] = -1;
+        } else {
+            for (Size i = 0; i < lines_.size(); i++) {
+                HeaderLine& line = lines_[i];
+                if (line.header == KNOWN_HEADER_NONE &&
+                    equalsIgnoreCase(line.name, name)) {
+                    line.value = String::null();
+                }
             }
+        }
+        appendHeaderLine(header, name, value);
+    }
+
+    void addHeaderLine(String::CPtr name, String::CPtr value) {
+        assert(name);
+        addHeaderLine(knownHeader(name), name, value);
+    }
+
+    // 'name' may be null if 'header' is a known one
+    void addHeaderLine(
+        KnownHeader header,
+        String::CPtr name,
+        String::CPtr value) {
+        assert(value);
+        assert(header != KNOWN_HEADER_NONE || name);
+
+        if (hasFlag(COMPLETE)) {
+            // trailers are rare, so they go to a plain JsObject
+            String::CPtr field = header != KNOWN_HEADER_NONE
+                ? knownHeaderName(header)
+                : name->toLowerCase();
+            putHeaderLine(trailers_, header, field, value);
         } else {
-            dest->put(field, value);
+            appendHeaderLine(header, name, value);
         }
     }
 
@@ -141,8 +256,10 @@ class IncomingMessage
         url_ = url;
     }
 
-    void setMethod(String::CPtr method) {
-        method_ = method;
+    void setMethod(Method method) {
+        methodCode_ = method;
+        method_ = methodName(method);
+        if (!method_) method_ = String::create();
     }
 
     Boolean hasEncoding() const {
@@ -157,6 +274,97 @@ class IncomingMessage
         return pendings_;
     }
 
+    Boolean isReadingBody() const {
+        return hasFlag(READING_BODY);
+    }
+
+    void appendBody(const char* data, Size length) {
+        assert(hasFlag(READING_BODY));
+        if (hasFlag(BODY_TOO_LARGE)) return;
+
+        if (bodyLength_ + length > bodyLimit_ ||
+            (body_ && bodyLength_ + length > body_->length())) {
+            bodyTooLarge();
+        } else if (body_) {
+            memcpy(
+                static_cast<char*>(const_cast<void*>(body_->data())) +
+                    bodyLength_,
+                data,
+                length);
+            bodyLength_ += length;
+        } else {
+            bodyChunks_->add(Buffer::create(data, length));
+            bodyLength_ += length;
+        }
+    }
+
+    void finishBody() {
+        assert(hasFlag(READING_BODY));
+        unsetFlag(READABLE);
+        if (hasFlag(BODY_TOO_LARGE) || hasFlag(END_EMITTED)) return;
+
+        setFlag(END_EMITTED);
+        Buffer::CPtr body;
+        if (body_) {
+            body = bodyLength_ == body_->length()
+                ? body_
+                : toCPtr<Buffer>(body_->slice(0, bodyLength_));
+        } else {
+            body = Buffer::concat(bodyChunks_, bodyLength_);
+        }
+        body_ = Buffer::null();
+        bodyChunks_ = JsArray::null();
+
+        JsFunction::Ptr callback = onReadBody_;
+        onReadBody_ = JsFunction::null();
+        if (callback) callback->call(libj::Error::null(), body);
+    }
+
+    // called when the body exceeds the limit of readBody
+    void setOnBodyTooLarge(JsFunction::Ptr callback) {
+        onBodyTooLarge_ = callback;
+    }
+
+    void setMaxBodySize(Size max) {
+        maxBodySize_ = max;
+    }
+
+    void setWaterMarks(Size high, Size low) {
+        highWaterMark_ = high;
+        lowWaterMark_ = low < high ? low : high;
+    }
+
+    void pushPending(Buffer::CPtr buf) {
+        pendings_->push(buf);
+        if (buf) {
+            pendingBytes_ += buf->length();
+            if (pendingBytes_ >= highWaterMark_) pauseSocket();
+        }
+    }
+
+    Buffer::CPtr shiftPending() {
+        Buffer::CPtr chunk = toCPtr<Buffer>(pendings_->remove(0));
+        if (chunk) {
+            assert(pendingBytes_ >= chunk->length());
+            pendingBytes_ -= chunk->length();
+        }
+        return chunk;
+    }
+
+    void pauseSocket() {
+        if (!hasFlag(SOCKET_PAUSED)) {
+            setFlag(SOCKET_PAUSED);
+            socket_->pause();
+        }
+    }
+
+    void resumeSocketIfDrained() {
+        if (pendingBytes_ <= lowWaterMark_) resumeSocket();
+    }
+
+    // the socket stays paused while the parser holds back the pipeline
+    void resumeSocket();
+
     void emitPending(JsFunction::Ptr callback = JsFunction::null()) {
         if (pendings_->isEmpty()) {
             if (callback) {
@@ -185,13 +393,146 @@ class IncomingMessage
         setFlag(END_EMITTED);
     }
 
+ private:
+    struct HeaderLine {
+        KnownHeader header;
+        String::CPtr name;   // null if 'header' is a known one
+        String::CPtr value;  // null if overwritten by setHeader
+        Int next;            // the next line of the same known header
+
+        HeaderLine(
+            KnownHeader h,
+            String::CPtr n,
+            String::CPtr v)
+            : header(h)
+            , name(n)
+            , value(v)
+            , next(-1) {}
+    };
+
+    void appendHeaderLine(
+        KnownHeader header,
+        String::CPtr name,
+        String::CPtr value) {
+        Int index = static_cast<Int>(lines_.size());
+        lines_.push_back(HeaderLine(
+            header,
+            header != KNOWN_HEADER_NONE ? String::null() : name,
+            value));
+        if (header != KNOWN_HEADER_NONE) {
+            Int* last = &known_[header];
+            while (*last >= 0) last = &lines_[*last].next;
+            *last = index;
+        }
+        headers_ = JsObject::null();
+    }
+
+    static void putHeaderLine(
+        JsObject::Ptr dest,
+        KnownHeader header,
+        String::CPtr field,
+        String::CPtr value) {
+        if (header == KNOWN_HEADER_SET_COOKIE) {
+            JsArray::Ptr vals = dest->getPtr<JsArray>(field);
+            if (!vals) {
+                vals = JsArray::create();
+                dest->put(field, vals);
+            }
+            vals->add(value);
+        } else {
+            Boolean join = header != KNOWN_HEADER_NONE
+                ? isCommaSeparated(header)
+                : isExtension(field);
+            dest->put(
+                field,
+                mergeValue(dest->getCPtr<String>(field), value, join));
+        }
+    }
+
+    // NO_SIZE unless the request has a valid Content-Length
+    Size contentLength() const {
+        String::CPtr value = getHeader(LHEADER_CONTENT_LENGTH);
+        if (!value || value->isEmpty()) return NO_SIZE;
+
+        Size length = 0;
+        Size len = value->length();
+        for (Size i = 0; i < len; i++) {
+            Char c = value->charAt(i);
+            if (c < '0' || c > '9') return NO_SIZE;
+            Size next = length * 10 + (c - '0');
+            if (next / 10 != length) return NO_SIZE;
+            length = next;
+        }
+        return length;
+    }
+
+    void bodyTooLarge() {
+        setFlag(BODY_TOO_LARGE);
+        body_ = Buffer::null();
+        bodyChunks_ = JsArray::null();
+
+        // keep reading, so that the rest of the body can be discarded
+        unsetFlag(PAUSED);
+        resumeSocket();
+
+        JsFunction::Ptr onTooLarge = onBodyTooLarge_;
+        onBodyTooLarge_ = JsFunction::null();
+        if (onTooLarge) (*onTooLarge)();
+
+        JsFunction::Ptr callback = onReadBody_;
+        onReadBody_ = JsFunction::null();
+        if (callback) {
+            callback->call(
+                http::Status::create(http::Status::REQUEST_ENTITY_TOO_LARGE));
+        }
+    }
+
+    // a repeated header overwrites the previous value
+    // unless its values are comma-separated
+    static String::CPtr mergeValue(
+        String::CPtr vals,
+        String::CPtr value,
+        Boolean join) {
+        if (!vals || !join) return value;
+
+        StringBuffer::Ptr sb = StringBuffer::create();
+        sb->append(vals);
+        sb->appendCStr(", ");
+        sb->append(value);
+        return sb->toString();
+    }
+
+    // 'x-' headers are comma-separated
+    static Boolean isExtension(String::CPtr name) {
+        return name->length() > 1 &&
+            (name->charAt(0) == 'x' || name->charAt(0) == 'X') &&
+            name->charAt(1) == '-';
+    }
+
+    static Boolean equalsIgnoreCase(String::CPtr s1, String::CPtr s2) {
+        Size len = s1->length();
+        if (s2->length() != len) return false;
+
+        for (Size i = 0; i < len; i++) {
+            Char c1 = s1->charAt(i);
+            Char c2 = s2->charAt(i);
+            if (c1 >= 'A' && c1 <= 'Z') c1 += 'a' - 'A';
+            if (c2 >= 'A' && c2 <= 'Z') c2 += 'a' - 'A';
+            if (c1 != c2) return false;
+        }
+        return true;
+    }
+
  public:
     typedef enum {
-        COMPLETE    = 1 << 0,
-        READABLE    = 1 << 1,
-        PAUSED      = 1 << 2,
-        END_EMITTED = 1 << 3,
-        UPGRADE     = 1 << 4,
+        COMPLETE       = 1 << 0,
+        READABLE       = 1 << 1,
+        PAUSED         = 1 << 2,
+        END_EMITTED    = 1 << 3,
+        UPGRADE        = 1 << 4,
+        SOCKET_PAUSED  = 1 << 5,
+        READING_BODY   = 1 << 6,
+        BODY_TOO_LARGE = 1 << 7,
     } Flag;
 
  private:
@@ -206,10 +547,9 @@ class IncomingMessage
         Value operator()(JsArray::Ptr args) {
             LinkedList::Ptr pendings = self_->getPendings();
             assert(pendings);
-            while (!self_->hasFlag(PAUSED) && self_->getPendings()->length()) {
-                Buffer::Ptr chunk = toPtr<Buffer>(pendings->remove(0));
+            while (!self_->hasFlag(PAUSED) && pendings->length()) {
+                Buffer::CPtr chunk = self_->shiftPending();
                 if (chunk) {
-                    assert(Buffer::isBuffer(chunk));
                     self_->emitData(chunk);
                 } else {
                     assert(pendings->isEmpty());
@@ -217,6 +557,7 @@ class IncomingMessage
                     self_->emitEnd();
                 }
             }
+            if (!self_->hasFlag(PAUSED)) self_->resumeSocketIfDrained();
             if (callback_)
                 (*callback_)();
             return libj::Status::OK;
@@ -237,25 +578,56 @@ class IncomingMessage
     net::SocketImpl::Ptr socket_;
     Int statusCode_;
     String::CPtr httpVersion_;
-    JsObject::Ptr headers_;
+    Int httpVersionMajor_;
+    Int httpVersionMinor_;
+    Int known_[NUM_KNOWN_HEADERS];
+    std::vector<HeaderLine> lines_;
+    mutable JsObject::Ptr headers_;
     JsObject::Ptr trailers_;
     String::CPtr url_;
     String::CPtr method_;
+    Method methodCode_;
     LinkedList::Ptr pendings_;
+    Size pendingBytes_;
+    Size highWaterMark_;
+    Size lowWaterMark_;
     StringDecoder::Ptr decoder_;
+    Buffer::Ptr body_;
+    JsArray::Ptr bodyChunks_;
+    Size bodyLength_;
+    Size bodyLimit_;
+    Size maxBodySize_;
+    JsFunction::Ptr onReadBody_;
+    JsFunction::Ptr onBodyTooLarge_;
     EventEmitter::Ptr ee_;
 
     IncomingMessage(net::SocketImpl::Ptr sock)
         : socket_(sock)
         , statusCode_(0)
         , httpVersion_(String::null())
-        , headers_(JsObject::create())
+        , httpVersionMajor_(0)
+        , httpVersionMinor_(0)
+        , headers_(JsObject::null())
         , trailers_(JsObject::create())
         , url_(String::create())
         , method_(String::null())
+        , methodCode_(METHOD_UNKNOWN)
         , pendings_(LinkedList::create())
+        , pendingBytes_(0)
+        , highWaterMark_(64 * 1024)
+        , lowWaterMark_(16 * 1024)
         , decoder_(StringDecoder::null())
+        , body_(Buffer::null())
+        , bodyChunks_(JsArray::null())
+        , bodyLength_(0)
+        , bodyLimit_(0)
+        , maxBodySize_(1024 * 1024)
+        , onReadBody_(JsFunction::null())
+        , onBodyTooLarge_(JsFunction::null())
         , ee_(EventEmitter::create()) {
+        for (Size i = 0; i < NUM_KNOWN_HEADERS; i++) {
+            known_[i] = -1;
+        }
         setFlag(READABLE);
     }
 
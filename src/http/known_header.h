@@ -0,0 +1,39 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_KNOWN_HEADER_H_
+#define LIBNODE_SRC_HTTP_KNOWN_HEADER_H_
+
+#include "libnode/http/header.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+#define LIBNODE_HTTP_KNOWN_HEADER_GEN(NAME, VAL) \
+    KNOWN_##NAME,
+
+enum KnownHeader {
+    KNOWN_HEADER_NONE = -1,
+    LIBNODE_HTTP_HEADER_MAP(LIBNODE_HTTP_KNOWN_HEADER_GEN)
+    NUM_KNOWN_HEADERS
+};
+
+#undef LIBNODE_HTTP_KNOWN_HEADER_GEN
+
+// case-insensitive lookup of the LIBNODE_HTTP_HEADER_MAP names,
+// which neither allocates nor converts 'name' to lower case
+KnownHeader knownHeader(const char* name, Size len);
+
+KnownHeader knownHeader(String::CPtr name);
+
+// the lower-cased name, e.g. LHEADER_CONTENT_TYPE
+Symbol::CPtr knownHeaderName(KnownHeader header);
+
+// whether repeated values are joined with ", "
+Boolean isCommaSeparated(KnownHeader header);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_KNOWN_HEADER_H_
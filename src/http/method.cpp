@@ -0,0 +1,58 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <libj/string_buffer.h>
+
+#include "libnode/http/method.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+#define LIBNODE_HTTP_METHOD_NAME_GEN(NAME, VAL) \
+    Symbol::create(VAL),
+
+static Symbol::CPtr* methodNames() {
+    static Symbol::CPtr names[] = {
+        LIBNODE_HTTP_METHOD_MAP(LIBNODE_HTTP_METHOD_NAME_GEN)
+    };
+    return names;
+}
+
+Symbol::CPtr methodName(Method method) {
+    if (method >= 0 && method < METHOD_UNKNOWN) {
+        return methodNames()[method];
+    } else {
+        return Symbol::null();
+    }
+}
+
+Method toMethod(String::CPtr name) {
+    if (!name) return METHOD_UNKNOWN;
+
+    Symbol::CPtr* names = methodNames();
+    for (Size i = 0; i < METHOD_UNKNOWN; i++) {
+        if (names[i]->equals(name)) return static_cast<Method>(i);
+    }
+    return METHOD_UNKNOWN;
+}
+
+LIBJ_SYMBOL_DEF(HTTP_VERSION_1_0, "1.0");
+LIBJ_SYMBOL_DEF(HTTP_VERSION_1_1, "1.1");
+
+String::CPtr httpVersion(Int major, Int minor) {
+    if (major == 1 && minor == 1) {
+        return HTTP_VERSION_1_1;
+    } else if (major == 1 && minor == 0) {
+        return HTTP_VERSION_1_0;
+    } else {
+        StringBuffer::Ptr sb = StringBuffer::create();
+        sb->append(major);
+        sb->appendChar('.');
+        sb->append(minor);
+        return sb->toString();
+    }
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -5,13 +5,23 @@
 
 #include <assert.h>
 #include <stdio.h>
-#include <libj/typed_linked_list.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
 
 #include "libnode/http.h"
 #include "libnode/stream/writable_stream.h"
 
 #include "../flag.h"
+#include "../ring_queue.h"
 #include "../net/socket_impl.h"
+#include "./compressor.h"
+#include "./date_cache.h"
+#include "./header_buffer.h"
+#include "./known_header.h"
+#include "./response_cache.h"
+#include "./status_line.h"
 
 namespace libj {
 namespace node {
@@ -25,6 +35,11 @@ class OutgoingMessage
         return Ptr(new OutgoingMessage());
     }
 
+    virtual ~OutgoingMessage() {
+        Compressor::release(compressor_);
+        delete recording_;
+    }
+
     Boolean destroy() {
         if (socket_) {
             return socket_->destroy();
@@ -79,7 +94,7 @@ class OutgoingMessage
     }
 
     Boolean write(const Value& chunk, Buffer::Encoding enc) {
-        LIBJ_STATIC_SYMBOL_DEF(symCRLF, "\r\n");
+        if (hasFlag(COMPRESSING)) return false;
 
         if (!header_ || header_->isEmpty()) {
             implicitHeader();
@@ -99,7 +114,20 @@ class OutgoingMessage
             return false;
         }
 
+        Value data = chunk;
+        if (compressor_) {
+            buf = compress(chunk, enc, Z_SYNC_FLUSH);
+            if (!buf) return false;
+            if (buf->isEmpty()) return true;
+
+            str = String::null();
+            data = buf;
+            enc = Buffer::NONE;
+        }
+        if (recording_) record(data, enc);
+
         if (hasFlag(CHUNKED_ENCODING)) {
+            corkSocket();
             if (str) {
                 Size len = Buffer::byteLength(str, enc);
                 StringBuffer::Ptr data = StringBuffer::create();
@@ -109,53 +137,117 @@ class OutgoingMessage
                 data->appendCStr("\r\n");
                 return send(data->toString(), enc);
             } else {
-                Size len = buf->length();
-                send(toHex(len)->concat(symCRLF));
+                send(chunkHeader(buf->length()));
                 send(buf);
-                return send(symCRLF);
+                return send(crlf());
             }
         } else {
-            return send(chunk, enc);
+            return send(data, enc);
+        }
+    }
+
+    // Content-Length is set to 'length' unless the header is already
+    // determined. the file must stay open until the callback is called.
+    Boolean sendFile(
+        int fd,
+        Size offset,
+        Size length,
+        JsFunction::Ptr cb = JsFunction::null()) {
+        if (fd < 0 || hasFlag(FINISHED) || hasFlag(COMPRESSING)) {
+            return false;
+        }
+
+        // the file may change before the response expires
+        setRecording(NULL);
+
+        if (!header_ || header_->isEmpty()) {
+            // the file goes out as it is
+            compression_ = Compressor::NONE;
+            if (!getHeader(LHEADER_CONTENT_LENGTH) &&
+                !getHeader(LHEADER_TRANSFER_ENCODING)) {
+                setHeader(HEADER_CONTENT_LENGTH, String::valueOf(length));
+            }
+            implicitHeader();
+        }
+
+        if (!hasFlag(HAS_BODY) || !length) {
+            if (cb) process::nextTick(cb);
+            return true;
+        }
+
+        JsArray::Ptr file = JsArray::create();
+        file->add(fd);
+        file->add(offset);
+        file->add(length);
+        file->add(cb);
+
+        if (hasFlag(CHUNKED_ENCODING)) {
+            send(chunkHeader(length));
+            send(file);
+            return send(crlf());
+        } else {
+            return send(file);
         }
     }
 
     Boolean end(const Value& data, Buffer::Encoding enc) {
-        if (hasFlag(FINISHED)) return false;
+        if (hasFlag(FINISHED) || hasFlag(COMPRESSING)) return false;
 
         if (!header_ || header_->isEmpty()) {
+            if (compression_ != Compressor::NONE) {
+                if (!data.isUndefined()) return endCompressed(data, enc);
+
+                compression_ = Compressor::NONE;
+            }
             implicitHeader();
         }
 
+        if (compressor_) {
+            Buffer::CPtr last = compress(data, enc, Z_FINISH);
+            Compressor::release(compressor_);
+            compressor_ = NULL;
+            if (!last) {
+                destroy();
+                return false;
+            }
+            return endRaw(last, Buffer::NONE);
+        } else {
+            return endRaw(data, enc);
+        }
+    }
+
+    // the body is ended as it is
+    Boolean endRaw(const Value& data, Buffer::Encoding enc) {
         Value d;
         if (hasFlag(HAS_BODY)) {
-            d = UNDEFINED;
-        } else {
             d = data;
+        } else {
+            d = UNDEFINED;
         }
 
         String::CPtr str = toCPtr<String>(d);
         Boolean hot =
             !hasFlag(HEADER_SENT) &&
             str && !str->isEmpty() &&
-            output_->isEmpty() &&
+            output_.isEmpty() &&
             socket_ && socket_->writable() &&
             socket_->httpMessage() == this;
 
         Boolean ret;
         if (hot) {
+            if (recording_) record(str, enc);
             if (hasFlag(CHUNKED_ENCODING)) {
                 Size len = Buffer::byteLength(str, enc);
                 StringBuffer::Ptr chunk = StringBuffer::create();
-                chunk->append(header_);
                 chunk->append(toHex(len));
                 chunk->appendCStr("\r\n");
                 chunk->append(str);
                 chunk->appendCStr("\r\n0\r\n");
                 chunk->append(trailer_);
                 chunk->appendCStr("\r\n");
-                ret = socket_->write(chunk->toString(), enc);
+                ret = socket_->write(withHeader(chunk->toString(), enc));
             } else {
-                ret = socket_->write(header_->concat(str), enc);
+                ret = socket_->write(withHeader(str, enc));
             }
             setFlag(HEADER_SENT);
         } else if (!d.isUndefined()) {
@@ -174,8 +266,16 @@ class OutgoingMessage
             }
         }
 
+        // the last chunk need not wait for the next tick
+        if (uncorkSocket_) uncorkSocket_->uncork();
+
+        if (recording_) {
+            recording_->finish();
+            setRecording(NULL);
+        }
+
         setFlag(FINISHED);
-        if (output_->length() == 0 && socket_->httpMessage() == this) {
+        if (output_.isEmpty() && socket_->httpMessage() == this) {
             finish();
         }
         return ret;
@@ -186,31 +286,21 @@ class OutgoingMessage
         String::CPtr reasonPhrase = String::null(),
         JsObject::CPtr obj = JsObject::null()) {
         statusCode_ = statusCode;
-        Status::CPtr status = Status::create(statusCode, reasonPhrase);
 
-        JsObject::CPtr headers;
-        if (obj && headers_) {
-            JsObject::Ptr hs = renderHeaders();
-            Set::CPtr keys = obj->keySet();
-            Iterator::Ptr itr = keys->iterator();
-            while (itr->hasNext()) {
-                Value key = itr->next();
-                hs->put(key, obj->get(key));
-            }
-            headers = hs;
-        } else if (headers_) {
-            headers = renderHeaders();
+        HeaderBuffer header;
+        const std::string* line =
+            reasonPhrase ? NULL : statusLine(statusCode);
+        if (line) {
+            header.append(*line);
         } else {
-            headers = obj;
+            Status::CPtr status = Status::create(statusCode, reasonPhrase);
+            header.append("HTTP/1.1 ");
+            header.append(String::valueOf(status->code()));
+            header.append(" ");
+            header.append(status->message());
+            header.append("\r\n");
         }
 
-        StringBuffer::Ptr statusLine = StringBuffer::create();
-        statusLine->appendCStr("HTTP/1.1 ");
-        statusLine->append(status->code());
-        statusLine->appendChar(' ');
-        statusLine->append(status->message());
-        statusLine->appendCStr("\r\n");
-
         if (statusCode == 204 || statusCode == 304 ||
             (statusCode >= 100 && statusCode < 200)) {
             unsetFlag(HAS_BODY);
@@ -220,13 +310,103 @@ class OutgoingMessage
             unsetFlag(SHOULD_KEEP_ALIVE);
         }
 
-        storeHeader(statusLine->toString(), headers);
+        if (compression_ != Compressor::NONE) {
+            obj = startCompression(obj);
+        }
+
+        storeHeader(&header, obj);
     }
 
     Int statusCode() const {
         return statusCode_;
     }
 
+    // bytes queued until the socket is assigned or writable again.
+    // write() returns false once they reach kOutputHighWaterMark.
+    Size outputSize() const {
+        return outputSize_;
+    }
+
+    Boolean headerStored() const {
+        return header_ && !header_->isEmpty();
+    }
+
+    // spliced into the header as it is, after the other headers
+    Boolean setHeaderBlock(HeaderBlock::CPtr block) {
+        if (header_ && !header_->isEmpty()) return false;
+
+        headerBlock_ = block;
+        return true;
+    }
+
+    // the body is compressed with 'enc' if the response turns out to be
+    // compressible and its length is unknown or 'minSize' bytes or more.
+    // a body of 'offloadSize' bytes or more given to end() at once is
+    // compressed in the libuv threadpool (0 for never).
+    void setCompression(
+        Compressor::Encoding enc,
+        Int level,
+        Size minSize,
+        Size offloadSize) {
+        if (header_ && !header_->isEmpty()) return;
+
+        compression_ = enc;
+        compressionLevel_ = level;
+        compressionMinSize_ = minSize;
+        compressionOffloadSize_ = offloadSize;
+    }
+
+    // the body is recorded as it is written, and handed to the cache
+    // when the message ends. 'recording' is deleted with this message.
+    void setRecording(ResponseCache::Recording* recording) {
+        delete recording_;
+        recording_ = recording;
+    }
+
+    // ends with a response from the cache in a single write, adding
+    // the header fields which depend on this request and connection
+    Boolean endCached(const CachedResponse& cached) {
+        if (hasFlag(FINISHED) || headerStored()) return false;
+
+        setRecording(NULL);
+        statusCode_ = cached.statusCode();
+
+        const std::string& body = cached.body();
+        HeaderBuffer response;
+        response.append(cached.head());
+        if (hasFlag(SEND_DATE) && !cached.hasDate()) {
+            response.append(dateHeaderLine());
+        }
+        response.append(HEADER_AGE);
+        response.append(": ");
+        response.appendDecimal(cached.age(time(NULL)));
+        response.append("\r\n");
+        if (!cached.hasContentLength()) {
+            response.append(HEADER_CONTENT_LENGTH);
+            response.append(": ");
+            response.appendDecimal(body.length());
+            response.append("\r\n");
+        }
+        storeConnection(&response, true);
+        response.append("\r\n");
+        response.append(body);
+
+        header_ = response.toBuffer();
+        setFlag(HEADER_SENT);
+        Boolean ret = writeRaw(header_, Buffer::NONE);
+
+        setFlag(FINISHED);
+        if (output_.isEmpty() && socket_ && socket_->httpMessage() == this) {
+            finish();
+        }
+        return ret;
+    }
+
+    // advertised in a 'Keep-Alive' header, 0 for none
+    void setKeepAliveTimeout(Size timeout) {
+        keepAliveTimeout_ = timeout;
+    }
+
     void assignSocket(Ptr self, net::SocketImpl::Ptr socket) {
         LIBJ_STATIC_SYMBOL_DEF(symHttpMessage, "httpMessage");
 
@@ -251,9 +431,9 @@ class OutgoingMessage
     }
 
     void writeContinue() {
-        static const String::CPtr header =
-            String::create("HTTP/1.1 100 Continue\r\n\r\n");
-        writeRaw(header, Buffer::UTF8);
+        static const Buffer::CPtr header =
+            Buffer::create(String::create("HTTP/1.1 100 Continue\r\n\r\n"));
+        writeRaw(header, Buffer::NONE);
         setFlag(SENT_100);
     }
 
@@ -283,6 +463,316 @@ class OutgoingMessage
         SocketOnClose() : socket_(NULL) {}
     };
 
+    class UncorkSocket : LIBJ_JS_FUNCTION(UncorkSocket)
+     public:
+        static Ptr create() {
+            return Ptr(new UncorkSocket());
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            uncork();
+            return libj::Status::OK;
+        }
+
+        void uncork() {
+            if (socket_) {
+                net::SocketImpl::Ptr socket = socket_;
+                socket_ = net::SocketImpl::null();
+                socket->uncork();
+            }
+        }
+
+        Boolean pending() const {
+            return !!socket_;
+        }
+
+        void setSocket(net::SocketImpl::Ptr socket) {
+            socket_ = socket;
+        }
+
+     private:
+        net::SocketImpl::Ptr socket_;
+
+        UncorkSocket() : socket_(net::SocketImpl::null()) {}
+    };
+
+    // the chunks written in this tick go out in one vectored write
+    // when the socket is uncorked on the next tick
+    void corkSocket() {
+        if (!socket_) return;
+
+        if (!uncorkSocket_) {
+            uncorkSocket_ = UncorkSocket::create();
+        } else if (uncorkSocket_->pending()) {
+            return;
+        }
+        socket_->cork();
+        uncorkSocket_->setSocket(socket_);
+        process::nextTick(uncorkSocket_);
+    }
+
+    // "<size in hex>\r\n"
+    static Buffer::CPtr chunkHeader(Size len) {
+        char s[24];
+        int n = snprintf(s, sizeof(s), "%zx\r\n", len);
+        return Buffer::create(s, n);
+    }
+
+    static Buffer::CPtr crlf() {
+        static const Buffer::CPtr buf = Buffer::create("\r\n", 2);
+        return buf;
+    }
+
+    // 'data' in bytes, as the socket would write it
+    static Boolean toBytes(
+        const Value& data,
+        Buffer::Encoding enc,
+        std::string* bytes) {
+        String::CPtr str = toCPtr<String>(data);
+        Buffer::CPtr buf = toCPtr<Buffer>(data);
+        if (str) {
+            if (enc == Buffer::NONE || enc == Buffer::UTF8) {
+                *bytes = str->toStdString();
+                return true;
+            }
+            buf = Buffer::create(str, enc);
+        }
+        if (!buf) return false;
+
+        bytes->assign(static_cast<const char*>(buf->data()), buf->length());
+        return true;
+    }
+
+    // 'data' through the compressor, or null if it fails
+    Buffer::CPtr compress(const Value& data, Buffer::Encoding enc, int flush) {
+        std::string in;
+        std::string out;
+        if ((!data.isUndefined() && !toBytes(data, enc, &in)) ||
+            !compressor_->deflate(in.data(), in.length(), flush, &out)) {
+            return Buffer::null();
+        }
+        return Buffer::create(out.data(), out.length());
+    }
+
+    // the name of the header 'h' in 'headers', or null
+    static String::CPtr findHeader(JsObject::CPtr headers, KnownHeader h) {
+        if (!headers) return String::null();
+
+        Set::CPtr keys = headers->keySet();
+        Iterator::Ptr itr = keys->iterator();
+        while (itr->hasNext()) {
+            String::CPtr key = toCPtr<String>(itr->next());
+            if (knownHeader(key) == h) return key;
+        }
+        return String::null();
+    }
+
+    // the header 'h' in 'extra', or else the one set by setHeader()
+    String::CPtr headerValue(JsObject::CPtr extra, KnownHeader h) const {
+        String::CPtr key = findHeader(extra, h);
+        if (key) {
+            return String::valueOf(extra->get(key));
+        } else {
+            return getHeader(knownHeaderName(h));
+        }
+    }
+
+    // 'length' is the length of the whole body, or NO_SIZE if unknown
+    Boolean shouldCompress(JsObject::CPtr extra, Size length) const {
+        // nothing to compress for HEAD, 204 and 304
+        if (!hasFlag(HAS_BODY)) return false;
+
+        Int code = statusCode_;
+        if (code == 204 || code == 206 || code == 304 ||
+            (code >= 100 && code < 200)) {
+            return false;
+        }
+
+        // already encoded, or a byte range of the identity body
+        if (headerValue(extra, KNOWN_HEADER_CONTENT_ENCODING) ||
+            headerValue(extra, KNOWN_HEADER_CONTENT_RANGE) ||
+            !Compressor::compressible(
+                headerValue(extra, KNOWN_HEADER_CONTENT_TYPE))) {
+            return false;
+        }
+
+        String::CPtr cacheControl =
+            headerValue(extra, KNOWN_HEADER_CACHE_CONTROL);
+        if (cacheControl &&
+            cacheControl->toLowerCase()->toStdString().find(
+                "no-transform") != std::string::npos) {
+            return false;
+        }
+
+        String::CPtr contentLength =
+            headerValue(extra, KNOWN_HEADER_CONTENT_LENGTH);
+        if (length == NO_SIZE && contentLength) {
+            length = strtoul(contentLength->toStdString().c_str(), NULL, 10);
+        }
+        return length == NO_SIZE || length >= compressionMinSize_;
+    }
+
+    // adds Accept-Encoding to Vary, in 'extra' if it has Vary
+    void addVary(JsObject::Ptr extra) {
+        LIBJ_STATIC_SYMBOL_DEF(symAcceptEncoding, "Accept-Encoding");
+
+        String::CPtr key = findHeader(extra, KNOWN_HEADER_VARY);
+        String::CPtr vary =
+            key ? String::valueOf(extra->get(key)) : getHeader(HEADER_VARY);
+        if (vary) {
+            std::string lower = vary->toLowerCase()->toStdString();
+            if (lower == "*" ||
+                lower.find("accept-encoding") != std::string::npos) {
+                return;
+            }
+            vary = vary->concat(String::create(", "))->concat(
+                symAcceptEncoding);
+        } else {
+            vary = symAcceptEncoding;
+        }
+
+        if (key) {
+            extra->put(key, vary);
+        } else {
+            setHeader(HEADER_VARY, vary);
+        }
+    }
+
+    // the headers given to writeHead() with the ones for the compressed
+    // body of unknown length, which is sent in chunks
+    JsObject::CPtr startCompression(JsObject::CPtr extra) {
+        Compressor::Encoding enc = compression_;
+        compression_ = Compressor::NONE;
+        if (!shouldCompress(extra, NO_SIZE)) {
+            return extra;
+        }
+
+        compressor_ = Compressor::acquire(enc, compressionLevel_);
+        if (!compressor_) return extra;
+
+        JsObject::Ptr headers = JsObject::create();
+        if (extra) {
+            Set::CPtr keys = extra->keySet();
+            Iterator::Ptr itr = keys->iterator();
+            while (itr->hasNext()) {
+                String::CPtr key = toCPtr<String>(itr->next());
+                if (knownHeader(key) != KNOWN_HEADER_CONTENT_LENGTH) {
+                    headers->put(key, extra->get(key));
+                }
+            }
+        }
+        removeHeader(HEADER_CONTENT_LENGTH);
+        headers->put(HEADER_CONTENT_ENCODING, Compressor::name(enc));
+        addVary(headers);
+        return headers;
+    }
+
+    // the whole body is known, so it is compressed at once
+    // and sent with Content-Length
+    Boolean endCompressed(const Value& data, Buffer::Encoding enc) {
+        LIBJ_STATIC_SYMBOL_DEF(symHttpMessage, "httpMessage");
+
+        Compressor::Encoding encoding = compression_;
+        compression_ = Compressor::NONE;
+
+        std::string body;
+        if (!toBytes(data, enc, &body) ||
+            !shouldCompress(JsObject::null(), body.length()) ||
+            !(compressor_ = Compressor::acquire(
+                encoding, compressionLevel_))) {
+            implicitHeader();
+            return endRaw(data, enc);
+        }
+
+        if (compressionOffloadSize_ &&
+            body.length() >= compressionOffloadSize_ &&
+            socket_ &&
+            socket_->httpMessage() == this) {
+            // the socket keeps this message until it is finished
+            Ptr self = socket_->getPtr<OutgoingMessage>(symHttpMessage);
+            if (self) {
+                CompressWork* work = new CompressWork(self, compressor_);
+                work->input.swap(body);
+                work->req.data = work;
+                if (!uv_queue_work(
+                        uv_default_loop(),
+                        &work->req,
+                        CompressWork::run,
+                        CompressWork::after)) {
+                    setFlag(COMPRESSING);
+                    return true;
+                }
+                body.swap(work->input);
+                delete work;
+            }
+        }
+
+        std::string out;
+        Boolean ok = compressor_->deflate(
+            body.data(), body.length(), Z_FINISH, &out);
+        return endCompressed(ok, body, out);
+    }
+
+    // sends the compressed body, or 'body' as it is if compression failed
+    Boolean endCompressed(
+        Boolean ok,
+        const std::string& body,
+        const std::string& out) {
+        Compressor::Encoding enc = compressor_->encoding();
+        Compressor::release(compressor_);
+        compressor_ = NULL;
+
+        if (ok) {
+            setHeader(HEADER_CONTENT_ENCODING, Compressor::name(enc));
+            addVary(JsObject::null());
+        }
+        const std::string& sent = ok ? out : body;
+        setHeader(HEADER_CONTENT_LENGTH, String::valueOf(sent.length()));
+        implicitHeader();
+        return endRaw(
+            Buffer::create(sent.data(), sent.length()),
+            Buffer::NONE);
+    }
+
+    // compresses a body in the libuv threadpool,
+    // where nothing but the zlib stream and the strings may be touched
+    class CompressWork {
+     public:
+        uv_work_t req;
+        Ptr self;
+        Compressor* compressor;
+        std::string input;
+        std::string output;
+        Boolean ok;
+
+        CompressWork(Ptr msg, Compressor* c)
+            : self(msg)
+            , compressor(c)
+            , ok(false) {}
+
+        static void run(uv_work_t* req) {
+            CompressWork* work = static_cast<CompressWork*>(req->data);
+            work->ok = work->compressor->deflate(
+                work->input.data(),
+                work->input.length(),
+                Z_FINISH,
+                &work->output);
+        }
+
+        // for libuv before and after uv_after_work_cb got the status
+        static void after(uv_work_t* req, int status) {
+            after(req);
+        }
+
+        static void after(uv_work_t* req) {
+            CompressWork* work = static_cast<CompressWork*>(req->data);
+            OutgoingMessage* self = &(*work->self);
+            self->unsetFlag(COMPRESSING);
+            self->endCompressed(work->ok, work->input, work->output);
+            delete work;
+        }
+    };
+
     String::CPtr toHex(Size val) {
         Size n;
         to<Size>(val, &n);
@@ -300,15 +790,31 @@ class OutgoingMessage
             String::CPtr str = toCPtr<String>(data);
             if (str) {
                 assert(header_);
-                return writeRaw(header_->concat(str), enc);
+                return writeRaw(withHeader(str, enc), Buffer::NONE);
             } else {
-                output_->add(0, header_);
-                outputEncodings_->addTyped(0, Buffer::UTF8);
+                // the header goes out in the same vectored write
+                buffer(header_, Buffer::NONE);
                 return writeRaw(data, enc);
             }
         }
     }
 
+    // the header followed by 'str' in one Buffer,
+    // encoding 'str' straight after the header bytes
+    Buffer::CPtr withHeader(String::CPtr str, Buffer::Encoding enc) {
+        if (enc != Buffer::NONE && enc != Buffer::UTF8) {
+            return header_->concat(Buffer::create(str, enc));
+        }
+
+        std::string body = str->toStdString();
+        Size len = header_->length();
+        Buffer::Ptr buf = Buffer::create(len + body.length());
+        char* dst = static_cast<char*>(const_cast<void*>(buf->data()));
+        memcpy(dst, header_->data(), len);
+        memcpy(dst + len, body.data(), body.length());
+        return buf;
+    }
+
     Boolean writeRaw(const Value& data, Buffer::Encoding enc) {
         String::CPtr str = toCPtr<String>(data);
         Buffer::CPtr buf = toCPtr<Buffer>(data);
@@ -316,155 +822,149 @@ class OutgoingMessage
             if (str->isEmpty()) return true;
         } else if (buf) {
             if (buf->isEmpty()) return true;
-        } else {
+        } else if (!isFile(data)) {
             return false;
         }
 
         if (socket_ &&
             socket_->httpMessage() == this &&
             socket_->writable()) {
-            while (output_->length()) {
-                if (!socket_->writable()) {
-                    buffer(data, enc);
-                    return false;
-                }
-                Value c = output_->remove(0);
-                Buffer::Encoding e = outputEncodings_->removeTyped(0);
-                socket_->write(c, e);
+            if (output_.isEmpty()) return writeSocket(data, enc);
+
+            Boolean ret = false;
+            socket_->cork();
+            writeOutput();
+            if (socket_->writable()) {
+                ret = writeSocket(data, enc);
+            } else {
+                buffer(data, enc);
             }
-            return socket_->write(data, enc);
+            socket_->uncork();
+            return ret;
         } else {
             buffer(data, enc);
-            return false;
+            return outputSize_ < kOutputHighWaterMark;
         }
     }
 
-    void buffer(const Value& data, Buffer::Encoding enc) {
-        String::CPtr str = toCPtr<String>(data);
-        if (str && str->isEmpty()) return;
+    // writes the queued output while the socket is writable, and returns
+    // the result of the last write (false if nothing has been written)
+    Boolean writeOutput() {
+        Boolean ret = false;
+        while (!output_.isEmpty() && socket_->writable()) {
+            Value data = output_.shift();
+            Buffer::CPtr buf = toCPtr<Buffer>(data);
+            if (buf) outputSize_ -= buf->length();
+            ret = writeSocket(data, Buffer::NONE);
+        }
+        return ret;
+    }
 
-        Buffer::CPtr buf = toCPtr<Buffer>(data);
-        if (buf && buf->isEmpty()) return;
+    // a file region queued by sendFile: [fd, offset, length, callback]
+    static Boolean isFile(const Value& data) {
+        return !!toCPtr<JsArray>(data);
+    }
 
-        Size length = output_->length();
+    Boolean writeSocket(const Value& data, Buffer::Encoding enc) {
+        JsArray::CPtr file = toCPtr<JsArray>(data);
+        if (file) {
+            int fd = -1;
+            Size offset = 0;
+            Size length = 0;
+            to<int>(file->get(0), &fd);
+            to<Size>(file->get(1), &offset);
+            to<Size>(file->get(2), &length);
+            return socket_->sendFile(
+                fd, offset, length, file->getPtr<JsFunction>(3));
+        } else {
+            return socket_->write(data, enc);
+        }
+    }
 
-        if (!length || !str) {
-            output_->add(data);
-            outputEncodings_->addTyped(enc);
-            return;
+    // strings are encoded as they are queued,
+    // so that the output is only Buffers and file regions
+    void buffer(const Value& data, Buffer::Encoding enc) {
+        Buffer::CPtr buf = toCPtr<Buffer>(data);
+        String::CPtr str = toCPtr<String>(data);
+        if (str) {
+            if (enc == Buffer::NONE) enc = Buffer::UTF8;
+            buf = Buffer::create(str, enc);
         }
 
-        Buffer::Encoding lastEnc = outputEncodings_->getTyped(length - 1);
-        Value lastData = output_->get(length - 1);
+        if (buf) {
+            if (buf->isEmpty()) return;
 
-        if ((enc != Buffer::NONE && lastEnc == enc) ||
-            (enc == Buffer::NONE && data.type() == lastData.type())) {
-            if (str) {
-                output_->set(
-                    length - 1,
-                    toCPtr<String>(lastData)->concat(str));
-            } else if (buf) {
-                output_->set(
-                    length -1,
-                    toCPtr<Buffer>(lastData)->concat(buf));
-            } else {
-                assert(false);
-            }
+            outputSize_ += buf->length();
+            output_.push(buf);
+        } else {
+            output_.push(data);
         }
-
-        output_->add(data);
-        outputEncodings_->addTyped(enc);
     }
 
-    void storeHeader(String::CPtr firstLine, JsObject::CPtr headers) {
-        LIBJ_STATIC_SYMBOL_DEF(symClose,     "close");
-        LIBJ_STATIC_SYMBOL_DEF(symChunked,   "chunked");
+    // 'header' has the first line, which is followed by
+    // the headers set by setHeader() unless 'extra' overrides them,
+    // those in 'extra' and the header block, in this order
+    void storeHeader(HeaderBuffer* header, JsObject::CPtr extra) {
+        UInt specials = 0;
+        Set::CPtr keys = headers_->keySet();
+        Iterator::Ptr itr = keys->iterator();
+        while (itr->hasNext()) {
+            String::CPtr key = toCPtr<String>(itr->next());
+            String::CPtr field = headerNames_->getCPtr<String>(key);
+            if (extra && extra->containsKey(field)) continue;
 
-        Boolean sentConnectionHeader = false;
-        Boolean sentContentLengthHeader = false;
-        Boolean sentTransferEncodingHeader = false;
-        Boolean sentDateHeader = false;
-        Boolean sentExpect = false;
-
-        StringBuffer::Ptr messageHader = StringBuffer::create();
-        messageHader->append(firstLine);
-        String::CPtr field;
-        Value value;
-
-        #define LIBNODE_OUTMSG_STORE(F, V) { \
-            messageHader->append(F); \
-            messageHader->appendCStr(": "); \
-            messageHader->append(V); \
-            messageHader->appendCStr("\r\n"); \
-            String::CPtr lowerField = F->toLowerCase(); \
-            if (lowerField->equals(LHEADER_CONNECTION)) { \
-                sentConnectionHeader = true; \
-                if (V.equals(symClose)) { \
-                    setFlag(LAST); \
-                } else { \
-                    setFlag(SHOULD_KEEP_ALIVE); \
-                } \
-            } else if (lowerField->equals(LHEADER_TRANSFER_ENCODING)) { \
-                sentTransferEncodingHeader = true; \
-                if (V.equals(symChunked)) { \
-                    setFlag(CHUNKED_ENCODING); \
-                } \
-            } else if (lowerField->equals(LHEADER_CONTENT_LENGTH)) { \
-                sentContentLengthHeader = true; \
-            } else if (lowerField->equals(LHEADER_DATE)) { \
-                sentDateHeader = true; \
-            } else if (lowerField->equals(LHEADER_EXPECT)) { \
-                sentExpect = true; \
-            } \
-        }
-
-        if (headers) {
-            Set::CPtr keys = headers->keySet();
-            Iterator::Ptr itr = keys->iterator();
+            specials |= storeHeaderValues(
+                header, field, headers_->get(key));
+        }
+
+        if (extra) {
+            keys = extra->keySet();
+            itr = keys->iterator();
             while (itr->hasNext()) {
-                field = toCPtr<String>(itr->next());
+                String::CPtr field = toCPtr<String>(itr->next());
                 assert(field);
-                value = headers->get(field);
-
-                JsArray::CPtr ary = toCPtr<JsArray>(value);
-                if (ary) {
-                    Size len = ary->length();
-                    for (Size i = 0; i < len; i++) {
-                        Value v = ary->get(i);
-                        LIBNODE_OUTMSG_STORE(field, v);
-                    }
-                } else {
-                    LIBNODE_OUTMSG_STORE(field, value);
-                }
+                specials |= storeHeaderValues(
+                    header, field, extra->get(field));
             }
         }
 
-        #undef LIBNODE_OUTMSG_STORE
+        if (headerBlock_) {
+            Buffer::CPtr bytes = headerBlock_->bytes();
+            header->append(bytes->data(), bytes->length());
+            specials |= headerBlock_->specials();
+        }
+
+        Boolean sentConnectionHeader = specials & HeaderBlock::CONNECTION;
+        Boolean sentContentLengthHeader =
+            specials & HeaderBlock::CONTENT_LENGTH;
+        Boolean sentTransferEncodingHeader =
+            specials & HeaderBlock::TRANSFER_ENCODING;
+        Boolean sentExpect = specials & HeaderBlock::EXPECT;
+
+        if (recording_) startRecording(*header, extra, specials);
+
+        if (specials & HeaderBlock::CONNECTION_CLOSE) {
+            setFlag(LAST);
+        } else if (sentConnectionHeader) {
+            setFlag(SHOULD_KEEP_ALIVE);
+        }
+        if (specials & HeaderBlock::CHUNKED) {
+            setFlag(CHUNKED_ENCODING);
+        }
 
-        // TODO(plenluno): date header
+        if (hasFlag(SEND_DATE) && !(specials & HeaderBlock::DATE)) {
+            header->append(dateHeaderLine());
+        }
 
         if (!sentConnectionHeader) {
-            Boolean shouldSendKeepAlive =
-                hasFlag(SHOULD_KEEP_ALIVE) &&
-                (sentContentLengthHeader ||
-                 hasFlag(USE_CHUNKED_ENCODING_BY_DEFAULT) ||
-                 true);  // this.agent
-            messageHader->append(HEADER_CONNECTION);
-            messageHader->appendCStr(": ");
-            if (shouldSendKeepAlive) {
-                messageHader->appendCStr("keep-alive");
-            } else {
-                setFlag(LAST);
-                messageHader->appendCStr("close");
-            }
-            messageHader->appendCStr("\r\n");
+            storeConnection(header, sentContentLengthHeader);
         }
 
         if (!sentContentLengthHeader && !sentTransferEncodingHeader) {
             if (hasFlag(HAS_BODY)) {
                 if (hasFlag(USE_CHUNKED_ENCODING_BY_DEFAULT)) {
-                    messageHader->append(HEADER_TRANSFER_ENCODING);
-                    messageHader->appendCStr(": chunked\r\n");
+                    header->append(HEADER_TRANSFER_ENCODING);
+                    header->append(": chunked\r\n");
                     setFlag(CHUNKED_ENCODING);
                 } else {
                     setFlag(LAST);
@@ -474,22 +974,125 @@ class OutgoingMessage
             }
         }
 
-        messageHader->appendCStr("\r\n");
-        header_ = messageHader->toString();
+        header->append("\r\n");
+        header_ = header->toBuffer();
         unsetFlag(HEADER_SENT);
 
         if (sentExpect) send(String::create());
     }
 
-    JsObject::Ptr renderHeaders() {
-        JsObject::Ptr headers = JsObject::create();
-        Set::CPtr keys = headers_->keySet();
-        Iterator::Ptr itr = keys->iterator();
-        while (itr->hasNext()) {
-            String::CPtr key = toCPtr<String>(itr->next());
-            headers->put(headerNames_->get(key), headers_->get(key));
+    void storeConnection(
+        HeaderBuffer* header,
+        Boolean sentContentLengthHeader) {
+        Boolean shouldSendKeepAlive =
+            hasFlag(SHOULD_KEEP_ALIVE) &&
+            (sentContentLengthHeader ||
+             hasFlag(USE_CHUNKED_ENCODING_BY_DEFAULT) ||
+             true);  // this.agent
+        header->append(HEADER_CONNECTION);
+        header->append(": ");
+        if (shouldSendKeepAlive) {
+            header->append("keep-alive");
+            // whole seconds, rounded down so that clients give up on
+            // the connection before the server closes it
+            Size timeout = keepAliveTimeout_ / 1000;
+            if (timeout) {
+                header->append("\r\n");
+                header->append("Keep-Alive: timeout=");
+                header->appendDecimal(timeout);
+            }
+        } else {
+            setFlag(LAST);
+            header->append("close");
+        }
+        header->append("\r\n");
+    }
+
+    // the response is recorded from the header fields stored so far,
+    // unless they take the connection or the framing over.
+    // a header block may hide Set-Cookie, so it is never recorded.
+    void startRecording(
+        const HeaderBuffer& header,
+        JsObject::CPtr extra,
+        UInt specials) {
+        const UInt kHopByHop =
+            HeaderBlock::CONNECTION |
+            HeaderBlock::TRANSFER_ENCODING |
+            HeaderBlock::EXPECT;
+        Boolean hasSetCookie =
+            !!findHeader(extra, KNOWN_HEADER_SET_COOKIE) ||
+            headers_->containsKey(LHEADER_SET_COOKIE);
+        Boolean ok =
+            !headerBlock_ &&
+            !(specials & kHopByHop) &&
+            recording_->start(
+                statusCode_,
+                header.bytes(),
+                headerValue(extra, KNOWN_HEADER_CACHE_CONTROL),
+                headerValue(extra, KNOWN_HEADER_VARY),
+                hasSetCookie,
+                !!(specials & HeaderBlock::DATE),
+                !!(specials & HeaderBlock::CONTENT_LENGTH));
+        if (!ok) setRecording(NULL);
+    }
+
+    void record(const Value& data, Buffer::Encoding enc) {
+        std::string bytes;
+        if (!toBytes(data, enc, &bytes) ||
+            !recording_->append(bytes.data(), bytes.length())) {
+            setRecording(NULL);
+        }
+    }
+
+    // appends 'field' with each value if 'value' is an array,
+    // and returns the HeaderBlock::Special which the field is
+    static UInt storeHeaderValues(
+        HeaderBuffer* header,
+        String::CPtr field,
+        const Value& value) {
+        UInt specials = 0;
+        JsArray::CPtr ary = toCPtr<JsArray>(value);
+        if (ary) {
+            Size len = ary->length();
+            for (Size i = 0; i < len; i++) {
+                specials |= storeHeaderValue(header, field, ary->get(i));
+            }
+        } else {
+            specials = storeHeaderValue(header, field, value);
+        }
+        return specials;
+    }
+
+    static UInt storeHeaderValue(
+        HeaderBuffer* header,
+        String::CPtr field,
+        const Value& value) {
+        LIBJ_STATIC_SYMBOL_DEF(symClose,     "close");
+        LIBJ_STATIC_SYMBOL_DEF(symChunked,   "chunked");
+
+        header->append(field);
+        header->append(": ");
+        header->append(String::valueOf(value));
+        header->append("\r\n");
+
+        switch (knownHeader(field)) {
+        case KNOWN_HEADER_CONNECTION:
+            return value.equals(symClose)
+                ? HeaderBlock::CONNECTION | HeaderBlock::CONNECTION_CLOSE
+                : HeaderBlock::CONNECTION;
+        case KNOWN_HEADER_TRANSFER_ENCODING:
+            return value.equals(symChunked)
+                ? HeaderBlock::TRANSFER_ENCODING | HeaderBlock::CHUNKED
+                : HeaderBlock::TRANSFER_ENCODING;
+        case KNOWN_HEADER_CONTENT_LENGTH:
+            return HeaderBlock::CONTENT_LENGTH;
+        case KNOWN_HEADER_DATE:
+            return HeaderBlock::DATE;
+        case KNOWN_HEADER_EXPECT:
+            return HeaderBlock::EXPECT;
+        default:
+            return 0;
         }
-        return headers;
     }
 
     void finish() {
@@ -501,14 +1104,10 @@ class OutgoingMessage
     void flush() {
         if (!socket_) return;
 
-        Boolean ret = false;
-        while (output_->length()) {
-            if (!socket_->writable()) return;
-
-            Value data = output_->remove(0);
-            Buffer::Encoding enc = outputEncodings_->removeTyped(0);
-            ret = socket_->write(data, enc);
-        }
+        socket_->cork();
+        Boolean ret = writeOutput();
+        socket_->uncork();
+        if (!output_.isEmpty()) return;
 
         if (hasFlag(FINISHED)) {
             finish();
@@ -522,13 +1121,12 @@ class OutgoingMessage
             writeHead(statusCode_);
         } else {
             assert(method_ && path_);
-            StringBuffer::Ptr sb = StringBuffer::create();
-            sb->append(method_);
-            sb->appendChar(' ');
-            sb->append(path_);
-            sb->appendCStr(" HTTP/1.1\r\n");
-            String::CPtr firstLine = sb->toString();
-            storeHeader(firstLine, renderHeaders());
+            HeaderBuffer header;
+            header.append(method_);
+            header.append(" ");
+            header.append(path_);
+            header.append(" HTTP/1.1\r\n");
+            storeHeader(&header, JsObject::null());
         }
     }
 
@@ -546,35 +1144,53 @@ class OutgoingMessage
         EXPECT_CONTINUE                 = 1 << 9,
         SENT_100                        = 1 << 10,
         SERVER_RESPONSE                 = 1 << 11,
+        COMPRESSING                     = 1 << 12,
     };
 
  private:
-    typedef TypedLinkedList<Buffer::Encoding> EncodingList;
+    static const Size kOutputHighWaterMark = 16 * 1024;
 
     net::SocketImpl::Ptr socket_;
     Int statusCode_;
+    Size keepAliveTimeout_;
     String::CPtr method_;
     String::CPtr path_;
-    String::CPtr header_;
+    Buffer::CPtr header_;
     String::CPtr trailer_;
+    HeaderBlock::CPtr headerBlock_;
+    Compressor::Encoding compression_;
+    Int compressionLevel_;
+    Size compressionMinSize_;
+    Size compressionOffloadSize_;
+    Compressor* compressor_;
+    ResponseCache::Recording* recording_;
     JsObject::Ptr headers_;
     JsObject::Ptr headerNames_;
-    LinkedList::Ptr output_;
-    EncodingList::Ptr outputEncodings_;
+    RingQueue<Value> output_;
+    Size outputSize_;
     SocketOnClose::Ptr socketOnClose_;
+    UncorkSocket::Ptr uncorkSocket_;
     EventEmitter::Ptr ee_;
 
     OutgoingMessage()
         : socket_(net::SocketImpl::null())
         , statusCode_(Status::OK)
+        , keepAliveTimeout_(0)
         , method_(String::null())
         , path_(String::null())
-        , header_(String::create())
+        , header_(Buffer::create())
         , trailer_(String::create())
+        , headerBlock_(HeaderBlock::null())
+        , compression_(Compressor::NONE)
+        , compressionLevel_(-1)
+        , compressionMinSize_(0)
+        , compressionOffloadSize_(0)
+        , compressor_(NULL)
+        , recording_(NULL)
         , headers_(JsObject::create())
         , headerNames_(JsObject::create())
-        , output_(LinkedList::create())
-        , outputEncodings_(EncodingList::create())
+        , outputSize_(0)
+        , uncorkSocket_(UncorkSocket::null())
         , ee_(EventEmitter::create()) {
         static SocketOnClose::Ptr socketOnClose = SocketOnClose::create();
         socketOnClose_ = socketOnClose;
@@ -5,10 +5,17 @@
 
 #include <assert.h>
 #include <http_parser.h>
+#include <string.h>
+#include <uv.h>
+
+#include <string>
+#include <vector>
 
 #include "libnode/buffer.h"
+#include "libnode/http/method.h"
 
 #include "./incoming_message.h"
+#include "./request_scanner.h"
 #include "../flag.h"
 
 namespace libj {
@@ -17,18 +24,69 @@ namespace http {
 
 class Parser : public FlagMixin {
  public:
+    // take a parser from the free list, or allocate a new one
+    static Parser* create(
+        enum http_parser_type type,
+        net::SocketImpl::Ptr sock,
+        Size maxHeaders = 0) {
+        std::vector<Parser*>& parsers = freeList();
+        if (parsers.empty()) {
+            return new Parser(type, sock, maxHeaders);
+        } else {
+            Parser* parser = parsers.back();
+            parsers.pop_back();
+            parser->reinitialize(type, sock, maxHeaders);
+            return parser;
+        }
+    }
+
+    // free 'parser' and keep it for reuse unless the free list is full
+    static void release(Parser* parser) {
+        assert(parser);
+        if (parser->hasFlag(RELEASED)) return;
+
+        parser->free();
+        std::vector<Parser*>& parsers = freeList();
+        if (parsers.size() < maxFree()) {
+            parser->setFlag(RELEASED);
+            parsers.push_back(parser);
+        } else {
+            delete parser;
+        }
+    }
+
+    // the free list is shared by all the servers on the loop
+    static void setMaxFree(Size max) {
+        maxFree() = max;
+        std::vector<Parser*>& parsers = freeList();
+        while (parsers.size() > max) {
+            delete parsers.back();
+            parsers.pop_back();
+        }
+    }
+
+    static Size numFree() {
+        return freeList().size();
+    }
+
     Parser(
         enum http_parser_type type,
         net::SocketImpl::Ptr sock,
         Size maxHeaders = 0)
-        : url_(String::null())
-        , method_(String::null())
+        : method_(METHOD_UNKNOWN)
         , maxHeadersCount_(maxHeaders)
-        , fields_(JsArray::create())
-        , values_(JsArray::create())
+        , maxHeaderSize_(0)
+        , headerSize_(0)
+        , messageStart_(now())
+        , highWaterMark_(0)
+        , lowWaterMark_(0)
+        , numFields_(0)
+        , numValues_(0)
         , socket_(sock)
         , incoming_(IncomingMessage::null())
-        , onIncoming_(JsFunction::null()) {
+        , onIncoming_(JsFunction::null())
+        , current_(Buffer::null())
+        , held_(Buffer::null()) {
         static http_parser_settings settings;
         static Boolean initSettings = false;
         if (!initSettings) {
@@ -48,11 +106,50 @@ class Parser : public FlagMixin {
 
     Int execute(Buffer::CPtr buf) {
         size_t len = buf->length();
-        size_t numParsed = http_parser_execute(
-                                &parser_,
-                                settings_,
-                                static_cast<const char*>(buf->data()),
-                                len);
+        if (hasFlag(PAUSED)) {
+            hold(buf);
+            return len;
+        }
+
+        const char* data = static_cast<const char*>(buf->data());
+        size_t numParsed = 0;
+        setFlag(EXECUTING);
+        if (hasFlag(FAST_SCAN)) {
+            numParsed = scanRequests(data, len);
+        }
+        if (numParsed < len && socket_ && !hasFlag(PAUSED)) {
+            current_ = buf;
+            numParsed += http_parser_execute(
+                            &parser_,
+                            settings_,
+                            data + numParsed,
+                            len - numParsed);
+            current_ = Buffer::null();
+            if (HTTP_PARSER_ERRNO(&parser_) == HPE_PAUSED) {
+                http_parser_pause(&parser_, 0);
+            }
+        }
+        unsetFlag(EXECUTING);
+
+        // the slices of a header block continued in the next read
+        // can not point into this buffer any longer
+        url_.spill();
+        for (Size i = 0; i < numFields_; i++) {
+            fields_[i].spill();
+        }
+        for (Size i = 0; i < numValues_; i++) {
+            values_[i].spill();
+        }
+
+        // the requests after a full pipeline wait for resume()
+        if (numParsed < len &&
+            hasFlag(PAUSED) &&
+            !parser_.upgrade &&
+            HTTP_PARSER_ERRNO(&parser_) == HPE_OK) {
+            hold(Buffer::create(data + numParsed, len - numParsed));
+            numParsed = len;
+        }
+
         if (!parser_.upgrade && numParsed != len) {
             return -1;
         } else {
@@ -70,8 +167,7 @@ class Parser : public FlagMixin {
     }
 
     void free() {
-        fields_ = JsArray::create();
-        values_ = JsArray::create();
+        clearHeaders();
         onIncoming_ = JsFunction::null();
         if (socket_) {
             socket_->setOnData(JsFunction::null());
@@ -80,6 +176,7 @@ class Parser : public FlagMixin {
         }
         socket_ = net::SocketImpl::null();
         incoming_ = IncomingMessage::null();
+        held_ = Buffer::null();
     }
 
     IncomingMessage::Ptr incoming() {
@@ -90,112 +187,246 @@ class Parser : public FlagMixin {
         onIncoming_ = onIncoming;
     }
 
+    void setWaterMarks(Size high, Size low) {
+        highWaterMark_ = high;
+        lowWaterMark_ = low;
+    }
+
+    // the limit on the bytes of the url, header names and values
+    // of a message, 0 for no limit
+    void setMaxHeaderSize(Size max) {
+        maxHeaderSize_ = max;
+    }
+
+    // whether execute() failed because of setMaxHeaderSize
+    Boolean headerOverflow() const {
+        return hasFlag(HEADER_OVERFLOW);
+    }
+
+    // the loop time when the message being parsed began, or when the
+    // parser was created if no message has begun yet. 0 between messages.
+    Long messageStart() const {
+        return messageStart_;
+    }
+
+    // whether http_parser has begun a message and not completed it
+    Boolean inMessage() const {
+        return hasFlag(IN_MESSAGE);
+    }
+
+    Boolean headersComplete() const {
+        return hasFlag(HEADERS_COMPLETE);
+    }
+
+    net::SocketImpl::Ptr socket() const {
+        return socket_;
+    }
+
+    // stop reading the socket until resume(). the messages after the
+    // one being parsed are held, even if they have been read already.
+    void pause() {
+        setFlag(PAUSED);
+        if (socket_) socket_->pause();
+    }
+
+    // parse the held messages, as if they were read again,
+    // and then the socket unless they pause the parser again
+    void resume() {
+        if (!hasFlag(PAUSED)) return;
+
+        unsetFlag(PAUSED);
+        if (!hasFlag(EXECUTING) && held_) {
+            Buffer::CPtr held = held_;
+            held_ = Buffer::null();
+            JsFunction::Ptr onData =
+                socket_ ? socket_->onData() : JsFunction::null();
+            if (onData) {
+                onData->call(held);
+            } else {
+                execute(held);
+            }
+        }
+
+        if (!hasFlag(PAUSED) && socket_ && socket_->readable()) {
+            socket_->resume();
+        }
+    }
+
+    // the bytes read but not parsed while the parser is paused
+    Size heldSize() const {
+        return held_ ? held_->length() : 0;
+    }
+
+    Boolean paused() const {
+        return hasFlag(PAUSED);
+    }
+
+    // let scanRequestHead parse the requests without a body,
+    // and http_parser the others
+    void setFastScan(Boolean fastScan) {
+        if (fastScan) {
+            setFlag(FAST_SCAN);
+        } else {
+            unsetFlag(FAST_SCAN);
+        }
+    }
+
+    void reinitialize(
+        enum http_parser_type type,
+        net::SocketImpl::Ptr sock,
+        Size maxHeaders = 0) {
+        http_parser_init(&parser_, type);
+        parser_.data = this;
+        flags_ = 0;
+        url_.clear();
+        clearHeaders();
+        method_ = METHOD_UNKNOWN;
+        maxHeadersCount_ = maxHeaders;
+        maxHeaderSize_ = 0;
+        headerSize_ = 0;
+        messageStart_ = now();
+        highWaterMark_ = 0;
+        lowWaterMark_ = 0;
+        socket_ = sock;
+        incoming_ = IncomingMessage::null();
+        onIncoming_ = JsFunction::null();
+        held_ = Buffer::null();
+    }
+
  private:
-    #define LIBNODE_STR_UPDATE(STR, AT, LEN) \
-        if (!STR) { \
-            STR = String::create(AT, String::UTF8, LEN); \
-        } else { \
-            STR = STR->concat(String::create(AT, String::UTF8, LEN)); \
+    // a string which the parser delivers in one or more fragments.
+    // it points into the buffer being parsed and is copied only when
+    // it is not contiguous there or survives the current execute().
+    class Slice {
+     public:
+        Slice() : at_(NULL), len_(0), spilled_(false) {}
+
+        void append(const char* at, size_t len) {
+            if (spilled_) {
+                str_.append(at, len);
+            } else if (!len_) {
+                at_ = at;
+                len_ = len;
+            } else if (at_ + len_ == at) {
+                len_ += len;
+            } else {
+                spill();
+                str_.append(at, len);
+            }
+        }
+
+        void spill() {
+            if (!spilled_ && len_) {
+                str_.assign(at_, len_);
+                spilled_ = true;
+            }
         }
 
+        void clear() {
+            at_ = NULL;
+            len_ = 0;
+            spilled_ = false;
+            str_.clear();
+        }
+
+        Boolean isEmpty() const {
+            return !length();
+        }
+
+        const char* data() const {
+            return spilled_ ? str_.data() : at_;
+        }
+
+        Size length() const {
+            return spilled_ ? str_.length() : len_;
+        }
+
+        String::CPtr toString() const {
+            return String::create(data(), String::UTF8, length());
+        }
+
+     private:
+        const char* at_;
+        Size len_;
+        Boolean spilled_;
+        std::string str_;
+    };
+
     static int onMessageBegin(http_parser* parser) {
         Parser* self = static_cast<Parser*>(parser->data);
-        self->url_ = String::null();
-        self->fields_->clear();
-        self->values_->clear();
+        self->setFlag(IN_MESSAGE);
+        self->unsetFlag(HEADERS_COMPLETE);
+        if (!self->messageStart_) self->messageStart_ = now();
+        self->headerSize_ = 0;
+        self->url_.clear();
+        self->clearHeaders();
         return 0;
     }
 
     static int onUrl(http_parser* parser, const char* at, size_t len) {
         Parser* self = static_cast<Parser*>(parser->data);
-        LIBNODE_STR_UPDATE(self->url_, at, len);
+        if (self->addHeaderSize(len)) return 1;
+        self->url_.append(at, len);
         return 0;
     }
 
     static int onHeaderField(
         http_parser* parser, const char* at, size_t len) {
         Parser* self = static_cast<Parser*>(parser->data);
-        JsArray::Ptr fields = self->fields_;
-        JsArray::Ptr values = self->values_;
-        Size numFields = fields->size();
-        Size numValues = values->size();
-        if (numFields == numValues) {
-            fields->add(String::null());
-        }
-
-        assert(fields->size() == numValues + 1);
-        String::CPtr field = fields->getCPtr<String>(numValues);
-        LIBNODE_STR_UPDATE(field, at, len);
-        fields->set(numValues, field);
+        if (self->addHeaderSize(len)) return 1;
+        if (self->numFields_ == self->numValues_) {
+            if (self->fields_.size() == self->numFields_) {
+                self->fields_.push_back(Slice());
+                self->values_.push_back(Slice());
+            }
+            self->fields_[self->numFields_++].clear();
+        }
+
+        assert(self->numFields_ == self->numValues_ + 1);
+        self->fields_[self->numFields_ - 1].append(at, len);
         return 0;
     }
 
     static int onHeaderValue(
         http_parser* parser, const char* at, size_t len) {
         Parser* self = static_cast<Parser*>(parser->data);
-        JsArray::Ptr fields = self->fields_;
-        JsArray::Ptr values = self->values_;
-        Size numFields = fields->size();
-        Size numValues = values->size();
-        if (numValues != numFields) {
-            values->add(String::null());
-        }
-
-        assert(values->size() == numFields);
-        String::CPtr value = values->getCPtr<String>(numFields - 1);
-        LIBNODE_STR_UPDATE(value, at, len);
-        values->set(numFields - 1, value);
+        if (self->addHeaderSize(len)) return 1;
+        if (self->numValues_ != self->numFields_) {
+            self->values_[self->numValues_++].clear();
+        }
+
+        assert(self->numValues_ == self->numFields_);
+        self->values_[self->numValues_ - 1].append(at, len);
         return 0;
     }
 
-    static int onHeadersComplete(http_parser* parser) {
-        LIBJ_STATIC_SYMBOL_DEF(symDelete,  "DELETE");
-        LIBJ_STATIC_SYMBOL_DEF(symGet,     "GET");
-        LIBJ_STATIC_SYMBOL_DEF(symHead,    "HEAD");
-        LIBJ_STATIC_SYMBOL_DEF(symPost,    "POST");
-        LIBJ_STATIC_SYMBOL_DEF(symPut,     "PUT");
-        LIBJ_STATIC_SYMBOL_DEF(symConnect, "CONNECT");
-        LIBJ_STATIC_SYMBOL_DEF(symOptions, "OPTIONS");
-        LIBJ_STATIC_SYMBOL_DEF(symTrace,   "TRACE");
+    #define LIBNODE_HTTP_METHOD_CASE_GEN(NAME, VAL) \
+        case HTTP_##NAME: \
+            return METHOD_##NAME;
+
+    static Method toMethod(unsigned char method) {
+        switch (method) {
+        LIBNODE_HTTP_METHOD_MAP(LIBNODE_HTTP_METHOD_CASE_GEN)
+        default:
+            return METHOD_UNKNOWN;
+        }
+    }
+
+    #undef LIBNODE_HTTP_METHOD_CASE_GEN
 
+    static int onHeadersComplete(http_parser* parser) {
         Parser* self = static_cast<Parser*>(parser->data);
         if (parser->type == HTTP_REQUEST) {
-            String::CPtr method;
-            switch (parser->method) {
-            case HTTP_DELETE:
-                method = symDelete;
-                break;
-            case HTTP_GET:
-                method = symGet;
-                break;
-            case HTTP_HEAD:
-                method = symHead;
-                break;
-            case HTTP_POST:
-                method = symPost;
-                break;
-            case HTTP_PUT:
-                method = symPut;
-                break;
-            case HTTP_CONNECT:
-                method = symConnect;
-                break;
-            case HTTP_OPTIONS:
-                method = symOptions;
-                break;
-            case HTTP_TRACE:
-                method = symTrace;
-                break;
-            default:
-                method = String::create();
-            }
-            self->method_ = method;
+            self->method_ = toMethod(parser->method);
         } else if (parser->type == HTTP_RESPONSE) {
             self->statusCode_ = static_cast<Int>(parser->status_code);
         }
 
         self->majorVer_ = static_cast<Int>(parser->http_major);
         self->minorVer_ = static_cast<Int>(parser->http_minor);
+        self->setFlag(HEADERS_COMPLETE);
+        self->unsetFlag(UPGRADE);
+        self->unsetFlag(SHOULD_KEEP_ALIVE);
         if (parser->upgrade) {
             self->setFlag(UPGRADE);
         }
@@ -208,45 +439,195 @@ class Parser : public FlagMixin {
 
     static int onBody(http_parser* parser, const char* at, size_t length) {
         Parser* self = static_cast<Parser*>(parser->data);
-        self->onBody(Buffer::create(at, length));
+        if (self->incoming_->isReadingBody()) {
+            self->incoming_->appendBody(at, length);
+            return 0;
+        }
+
+        Buffer::CPtr current = self->current_;
+        if (current &&
+            at == current->data() &&
+            length == current->length()) {
+            // a read which is all body. the stream allocates a new buffer
+            // for every read, so it can be handed over without a copy.
+            self->onBody(current);
+        } else {
+            self->onBody(Buffer::create(at, length));
+        }
         return 0;
     }
 
     static int onMessageComplete(http_parser* parser) {
         Parser* self = static_cast<Parser*>(parser->data);
+        self->unsetFlag(IN_MESSAGE);
         self->onMessageComplete();
+
+        // stop before the next message, which execute() holds
+        if (self->hasFlag(PAUSED)) http_parser_pause(parser, 1);
         return 0;
     }
 
-    #undef LIBNODE_STR_UPDATE
+ private:
+    size_t scanRequests(const char* data, size_t len) {
+        size_t offset = 0;
+        while (offset < len &&
+               socket_ &&
+               !hasFlag(IN_MESSAGE) &&
+               !hasFlag(PAUSED)) {
+            RequestHead head;
+            Int r = scanRequestHead(data + offset, len - offset, &head);
+            if (r < 0) break;
+            // http_parser tells the oversized heads from the others
+            if (maxHeaderSize_ && static_cast<Size>(r) > maxHeaderSize_) break;
+            if (!emitRequest(head)) break;
+            offset += r;
+        }
+        return offset;
+    }
+
+    static Boolean equalsToken(
+        const RequestHead::Token& token,
+        const char* str) {
+        Size len = strlen(str);
+        return token.len == len && !memcmp(token.at, str, len);
+    }
+
+    static Boolean equalsTokenIgnoreCase(
+        const RequestHead::Token& token,
+        const char* lstr) {
+        Size len = strlen(lstr);
+        if (token.len != len) return false;
+        for (Size i = 0; i < len; i++) {
+            char c = token.at[i];
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            if (c != lstr[i]) return false;
+        }
+        return true;
+    }
+
+    // returns false, doing nothing, if the request is left to http_parser
+    Boolean emitRequest(const RequestHead& head) {
+        #define LIBNODE_HTTP_METHOD_NAME_GEN(NAME, VAL) VAL,
+
+        static const char* methods[] = {
+            LIBNODE_HTTP_METHOD_MAP(LIBNODE_HTTP_METHOD_NAME_GEN)
+        };
+
+        #undef LIBNODE_HTTP_METHOD_NAME_GEN
+
+        Method method = METHOD_UNKNOWN;
+        for (Size i = 0; i < METHOD_UNKNOWN; i++) {
+            if (equalsToken(head.method, methods[i])) {
+                method = static_cast<Method>(i);
+                break;
+            }
+        }
+        if (method == METHOD_UNKNOWN || method == METHOD_CONNECT) {
+            return false;
+        }
+
+        // no body, no upgrade and a persistent connection
+        Boolean keepAlive = head.minorVersion >= 1;
+        for (Size i = 0; i < head.numHeaders; i++) {
+            const RequestHead::Token& value = head.values[i];
+            switch (knownHeader(head.names[i].at, head.names[i].len)) {
+            case KNOWN_HEADER_CONTENT_LENGTH:
+                if (!equalsToken(value, "0")) return false;
+                break;
+            case KNOWN_HEADER_TRANSFER_ENCODING:
+            case KNOWN_HEADER_UPGRADE:
+                return false;
+            case KNOWN_HEADER_CONNECTION:
+                if (equalsTokenIgnoreCase(value, "keep-alive")) {
+                    keepAlive = true;
+                } else {
+                    return false;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        if (!keepAlive) return false;
+
+        url_.clear();
+        url_.append(head.url.at, head.url.len);
+        clearHeaders();
+        for (Size i = 0; i < head.numHeaders; i++) {
+            if (fields_.size() == i) {
+                fields_.push_back(Slice());
+                values_.push_back(Slice());
+            }
+            fields_[i].clear();
+            fields_[i].append(head.names[i].at, head.names[i].len);
+            values_[i].clear();
+            values_[i].append(head.values[i].at, head.values[i].len);
+        }
+        numFields_ = head.numHeaders;
+        numValues_ = head.numHeaders;
+
+        method_ = method;
+        majorVer_ = head.majorVersion;
+        minorVer_ = head.minorVersion;
+        unsetFlag(UPGRADE);
+        setFlag(SHOULD_KEEP_ALIVE);
+
+        onHeadersComplete();
+        if (incoming_) onMessageComplete();
+        return true;
+    }
 
  private:
-    int onHeadersComplete() {
-        StringBuffer::Ptr httpVer = StringBuffer::create();
-        httpVer->append(majorVer_);
-        httpVer->appendChar('.');
-        httpVer->append(minorVer_);
+    static Long now() {
+        return static_cast<Long>(uv_now(uv_default_loop()));
+    }
 
-        incoming_ = IncomingMessage::create(socket_);
-        incoming_->setUrl(url_);
-        incoming_->setHttpVersion(httpVer->toString());
+    // returns true, and the parser stops, if the head gets too large
+    Boolean addHeaderSize(size_t len) {
+        headerSize_ += len;
+        if (maxHeaderSize_ && headerSize_ > maxHeaderSize_) {
+            setFlag(HEADER_OVERFLOW);
+            return true;
+        } else {
+            return false;
+        }
+    }
 
-        Size n = fields_->length();
-        assert(values_->length() == n);
-        if (!maxHeadersCount_) {
-            n = n < maxHeadersCount_ ? n : maxHeadersCount_;
+    void clearHeaders() {
+        numFields_ = 0;
+        numValues_ = 0;
+    }
+
+    void addHeaderLines() {
+        Size n = numValues_;
+        if (maxHeadersCount_ && n > maxHeadersCount_) {
+            n = maxHeadersCount_;
         }
         for (Size i = 0; i < n; i++) {
+            const Slice& field = fields_[i];
+            KnownHeader header = knownHeader(field.data(), field.length());
             incoming_->addHeaderLine(
-                fields_->getCPtr<String>(i),
-                values_->getCPtr<String>(i));
+                header,
+                header == KNOWN_HEADER_NONE
+                    ? field.toString()
+                    : String::null(),
+                values_[i].toString());
         }
+        clearHeaders();
+    }
 
-        url_ = String::null();
-        fields_ = JsArray::create();
-        values_ = JsArray::create();
+    int onHeadersComplete() {
+        incoming_ = IncomingMessage::create(socket_);
+        if (highWaterMark_) {
+            incoming_->setWaterMarks(highWaterMark_, lowWaterMark_);
+        }
+        if (!url_.isEmpty()) incoming_->setUrl(url_.toString());
+        incoming_->setHttpVersion(majorVer_, minorVer_);
+
+        addHeaderLines();
+        url_.clear();
 
-        if (method_) {
+        if (parser_.type == HTTP_REQUEST) {
             incoming_->setMethod(method_);
         } else {
             incoming_->setStatusCode(statusCode_);
@@ -263,45 +644,49 @@ class Parser : public FlagMixin {
         return skipBody;
     }
 
+    void hold(Buffer::CPtr buf) {
+        held_ = held_ ? held_->concat(buf) : buf;
+    }
+
     void onBody(Buffer::CPtr buf) {
         LinkedList::Ptr pendings = incoming_->getPendings();
         if (incoming_->hasFlag(IncomingMessage::PAUSED) ||
             pendings->length()) {
-            pendings->push(buf);
+            incoming_->pushPending(buf);
         } else {
             incoming_->emitData(buf);
         }
     }
 
     void onMessageComplete() {
+        messageStart_ = 0;
         incoming_->setFlag(IncomingMessage::COMPLETE);
 
-        if (!fields_->isEmpty()) {
-            Size n = fields_->size();
-            assert(values_->size() == n);
-            for (Size i = 0; i < n; i++) {
-                incoming_->addHeaderLine(
-                    fields_->getCPtr<String>(i),
-                    values_->getCPtr<String>(i));
-            }
-            url_ = String::null();
-            fields_->clear();
-            values_->clear();
+        // trailers
+        if (numFields_) {
+            addHeaderLines();
+            url_.clear();
         }
 
-        if (!incoming_->hasFlag(IncomingMessage::UPGRADE)) {
+        if (incoming_->isReadingBody()) {
+            incoming_->finishBody();
+        } else if (!incoming_->hasFlag(IncomingMessage::UPGRADE)) {
             LinkedList::Ptr pendings = incoming_->getPendings();
             if (incoming_->hasFlag(IncomingMessage::PAUSED) ||
                 pendings->length()) {
-                pendings->push(0);  // EOF
+                incoming_->pushPending(Buffer::null());  // EOF
             } else {
                 incoming_->unsetFlag(IncomingMessage::READABLE);
                 incoming_->emitEnd();
             }
         }
 
-        if (socket_->readable()) {
-            // socket_->resume();
+        // force to read the next incoming message, unless the body of
+        // this one is still over the water mark or the pipeline is full
+        if (socket_->readable() &&
+            !hasFlag(PAUSED) &&
+            !incoming_->hasFlag(IncomingMessage::SOCKET_PAUSED)) {
+            socket_->resume();
         }
     }
 
@@ -310,22 +695,48 @@ class Parser : public FlagMixin {
         HAVE_FLUSHED      = 1 << 0,
         UPGRADE           = 1 << 1,
         SHOULD_KEEP_ALIVE = 1 << 2,
+        RELEASED          = 1 << 3,
+        FAST_SCAN         = 1 << 4,
+        IN_MESSAGE        = 1 << 5,
+        HEADERS_COMPLETE  = 1 << 6,
+        HEADER_OVERFLOW   = 1 << 7,
+        PAUSED            = 1 << 8,
+        EXECUTING         = 1 << 9,
     };
 
+    static std::vector<Parser*>& freeList() {
+        static std::vector<Parser*> parsers;
+        return parsers;
+    }
+
+    static Size& maxFree() {
+        static Size max = 1000;
+        return max;
+    }
+
  private:
     http_parser parser_;
     http_parser_settings* settings_;
-    String::CPtr url_;
-    String::CPtr method_;
+    Slice url_;
+    Method method_;
     Int majorVer_;
     Int minorVer_;
     Int statusCode_;
     Size maxHeadersCount_;
-    JsArray::Ptr fields_;
-    JsArray::Ptr values_;
+    Size maxHeaderSize_;
+    Size headerSize_;
+    Long messageStart_;
+    Size highWaterMark_;
+    Size lowWaterMark_;
+    Size numFields_;
+    Size numValues_;
+    std::vector<Slice> fields_;
+    std::vector<Slice> values_;
     net::SocketImpl::Ptr socket_;
     IncomingMessage::Ptr incoming_;
     JsFunction::Ptr onIncoming_;
+    Buffer::CPtr current_;
+    Buffer::CPtr held_;
 };
 
 }  // namespace http
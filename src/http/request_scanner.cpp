@@ -0,0 +1,159 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifdef LIBNODE_USE_SSE42
+#include <nmmintrin.h>
+#endif
+
+#include "./request_scanner.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// inclusive [lo, hi] pairs of the bytes which end a token,
+// padded to the 16 bytes which _mm_loadu_si128 reads
+static const char TOKEN_STOPS[16] = "\x00\x20\x7f\x7f";
+static const char NAME_STOPS[16] = "\x00\x20::\x7f\x7f";
+static const char VALUE_STOPS[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+
+static const Size NUM_TOKEN_STOPS = 4;
+static const Size NUM_NAME_STOPS = 6;
+static const Size NUM_VALUE_STOPS = 6;
+
+static inline Boolean isStop(
+    unsigned char c,
+    const char* ranges,
+    Size numRanges) {
+    for (Size i = 0; i < numRanges; i += 2) {
+        if (c >= static_cast<unsigned char>(ranges[i]) &&
+            c <= static_cast<unsigned char>(ranges[i + 1])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the first byte in [p, end) which is in 'ranges', or 'end'
+static inline const char* findStop(
+    const char* p,
+    const char* end,
+    const char* ranges,
+    Size numRanges) {
+#ifdef LIBNODE_USE_SSE42
+    __m128i stops = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int i = _mm_cmpestri(
+            stops, static_cast<int>(numRanges),
+            bytes, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (i != 16) return p + i;
+        p += 16;
+    }
+#endif
+    for (; p != end; p++) {
+        if (isStop(static_cast<unsigned char>(*p), ranges, numRanges)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+#define LIBNODE_HTTP_SCAN(P, END, STOPS) \
+    findStop(P, END, STOPS, NUM_##STOPS)
+
+// CRLF or a bare LF
+static inline Int scanEol(const char** p, const char* end) {
+    if (*p == end) return SCAN_INCOMPLETE;
+    if (**p == '\r') {
+        if (++*p == end) return SCAN_INCOMPLETE;
+    }
+    if (**p != '\n') return SCAN_UNSUPPORTED;
+    ++*p;
+    return 0;
+}
+
+Int scanRequestHead(const char* buf, Size len, RequestHead* head) {
+    const char* p = buf;
+    const char* end = buf + len;
+    const char* q;
+    Int r;
+
+    // method
+    q = LIBNODE_HTTP_SCAN(p, end, TOKEN_STOPS);
+    if (q == end) return SCAN_INCOMPLETE;
+    if (q == p || *q != ' ') return SCAN_UNSUPPORTED;
+    head->method.at = p;
+    head->method.len = q - p;
+    p = q + 1;
+
+    // url
+    q = LIBNODE_HTTP_SCAN(p, end, TOKEN_STOPS);
+    if (q == end) return SCAN_INCOMPLETE;
+    if (q == p || *q != ' ') return SCAN_UNSUPPORTED;
+    head->url.at = p;
+    head->url.len = q - p;
+    p = q + 1;
+
+    // version
+    static const char version[] = "HTTP/1.";
+    for (Size i = 0; i < sizeof(version) - 1; i++, p++) {
+        if (p == end) return SCAN_INCOMPLETE;
+        if (*p != version[i]) return SCAN_UNSUPPORTED;
+    }
+    if (p == end) return SCAN_INCOMPLETE;
+    if (*p < '0' || *p > '9') return SCAN_UNSUPPORTED;
+    head->majorVersion = 1;
+    head->minorVersion = *p++ - '0';
+    if ((r = scanEol(&p, end))) return r;
+
+    // headers
+    head->numHeaders = 0;
+    while (true) {
+        if (p == end) return SCAN_INCOMPLETE;
+        if (*p == '\r' || *p == '\n') {
+            if ((r = scanEol(&p, end))) return r;
+            return static_cast<Int>(p - buf);
+        }
+        if (head->numHeaders == RequestHead::MAX_HEADERS) {
+            return SCAN_UNSUPPORTED;
+        }
+
+        // name
+        q = LIBNODE_HTTP_SCAN(p, end, NAME_STOPS);
+        if (q == end) return SCAN_INCOMPLETE;
+        if (q == p || *q != ':') return SCAN_UNSUPPORTED;
+        RequestHead::Token& name = head->names[head->numHeaders];
+        name.at = p;
+        name.len = q - p;
+        p = q + 1;
+
+        // value
+        while (p != end && (*p == ' ' || *p == '\t')) p++;
+        q = LIBNODE_HTTP_SCAN(p, end, VALUE_STOPS);
+        if (q == end) return SCAN_INCOMPLETE;
+        if (*q != '\r' && *q != '\n') return SCAN_UNSUPPORTED;
+        const char* valueEnd = q;
+        while (valueEnd != p &&
+               (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+            valueEnd--;
+        }
+        RequestHead::Token& value = head->values[head->numHeaders];
+        value.at = p;
+        value.len = valueEnd - p;
+        p = q;
+        if ((r = scanEol(&p, end))) return r;
+
+        // obs-fold
+        if (p == end) return SCAN_INCOMPLETE;
+        if (*p == ' ' || *p == '\t') return SCAN_UNSUPPORTED;
+
+        head->numHeaders++;
+    }
+}
+
+#undef LIBNODE_HTTP_SCAN
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
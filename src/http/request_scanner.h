@@ -0,0 +1,46 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_REQUEST_SCANNER_H_
+#define LIBNODE_SRC_HTTP_REQUEST_SCANNER_H_
+
+#include <libj/string.h>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// the head of an HTTP/1.x request, pointing into the scanned bytes
+struct RequestHead {
+    static const Size MAX_HEADERS = 64;
+
+    struct Token {
+        const char* at;
+        Size len;
+    };
+
+    Token method;
+    Token url;
+    Int majorVersion;
+    Int minorVersion;
+    Size numHeaders;
+    Token names[MAX_HEADERS];
+    Token values[MAX_HEADERS];
+};
+
+// scans a request line and header block in one pass, looking for the
+// delimiters 16 bytes at a time with SSE4.2 if LIBNODE_USE_SSE42 is set.
+// returns the length of the head, SCAN_INCOMPLETE if 'buf' ends
+// before it, or SCAN_UNSUPPORTED if it is malformed, folded or has more
+// than MAX_HEADERS headers, which are left to http_parser.
+enum {
+    SCAN_UNSUPPORTED = -1,
+    SCAN_INCOMPLETE  = -2,
+};
+
+Int scanRequestHead(const char* buf, Size len, RequestHead* head);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_REQUEST_SCANNER_H_
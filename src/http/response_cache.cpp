@@ -0,0 +1,304 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "libnode/http/header.h"
+#include "libnode/http/status.h"
+
+#include "./response_cache.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// -- Cache-Control --
+
+struct CacheControl {
+    Boolean noStore;
+    Boolean noCache;
+    Boolean isPrivate;
+    Long maxAge;
+    Long sMaxAge;
+};
+
+static std::string trimLower(const std::string& str, Size begin, Size end) {
+    while (begin < end && isspace(static_cast<unsigned char>(str[begin]))) {
+        begin++;
+    }
+    while (end > begin && isspace(static_cast<unsigned char>(str[end - 1]))) {
+        end--;
+    }
+
+    std::string s;
+    for (Size i = begin; i < end; i++) {
+        s += static_cast<char>(tolower(static_cast<unsigned char>(str[i])));
+    }
+    return s;
+}
+
+// -1 for a max-age which is not given
+static CacheControl parseCacheControl(String::CPtr value) {
+    CacheControl cc = { false, false, false, -1, -1 };
+    if (!value) return cc;
+
+    std::string directives = value->toStdString();
+    Size start = 0;
+    while (start < directives.length()) {
+        Size end = directives.find(',', start);
+        if (end == std::string::npos) end = directives.length();
+
+        std::string directive = trimLower(directives, start, end);
+        Size eq = directive.find('=');
+        std::string name = directive.substr(0, eq);
+        std::string arg;
+        if (eq != std::string::npos) {
+            arg = directive.substr(eq + 1);
+            if (arg.length() >= 2 && arg[0] == '"') {
+                arg = arg.substr(1, arg.length() - 2);
+            }
+        }
+
+        if (name == "no-store") {
+            cc.noStore = true;
+        } else if (name == "no-cache") {
+            cc.noCache = true;
+        } else if (name == "private") {
+            cc.isPrivate = true;
+        } else if (name == "max-age" && !arg.empty()) {
+            cc.maxAge = atol(arg.c_str());
+        } else if (name == "s-maxage" && !arg.empty()) {
+            cc.sMaxAge = atol(arg.c_str());
+        }
+        start = end + 1;
+    }
+    return cc;
+}
+
+static Boolean isCacheableStatus(Int code) {
+    switch (code) {
+    case Status::OK:
+    case Status::NON_AUTHORITATIVE_INFORMATION:
+    case Status::MULTIPLE_CHOICES:
+    case Status::MOVED_PERMANENTLY:
+    case Status::NOT_FOUND:
+    case Status::GONE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// only GET without credentials
+static Boolean isCacheableRequest(const ResponseCache::Request& req) {
+    return req.method() == METHOD_GET &&
+        req.url() &&
+        !req.header(LHEADER_AUTHORIZATION);
+}
+
+// -- ResponseCache::Recording --
+
+ResponseCache::Recording::Recording(ResponseCache* cache, Request* req)
+    : cache_(cache)
+    , request_(req)
+    , response_(new CachedResponse())
+    , started_(false)
+    , maxSize_(cache->capacity_ / kMaxEntryRatio) {}
+
+ResponseCache::Recording::~Recording() {
+    delete response_;
+    delete request_;
+}
+
+Boolean ResponseCache::Recording::start(
+    Int statusCode,
+    const std::string& head,
+    String::CPtr cacheControl,
+    String::CPtr vary,
+    Boolean hasSetCookie,
+    Boolean hasDate,
+    Boolean hasContentLength) {
+    if (!response_ || started_) return false;
+
+    CacheControl cc = parseCacheControl(cacheControl);
+    Long lifetime = cc.sMaxAge >= 0 ? cc.sMaxAge : cc.maxAge;
+    if (!isCacheableStatus(statusCode) ||
+        cc.noStore || cc.noCache || cc.isPrivate || lifetime <= 0 ||
+        hasSetCookie) {
+        return fail();
+    }
+
+    if (vary) {
+        std::string names = vary->toStdString();
+        Size start = 0;
+        while (start < names.length()) {
+            Size end = names.find(',', start);
+            if (end == std::string::npos) end = names.length();
+
+            std::string name = trimLower(names, start, end);
+            if (name == "*") return fail();
+            if (!name.empty()) vary_.push_back(String::create(name.c_str()));
+            start = end + 1;
+        }
+    }
+
+    std::string primary = primaryKey(*request_);
+    response_->key_ = variantKey(primary, vary_, *request_);
+    response_->primary_ = primary;
+    response_->statusCode_ = statusCode;
+    response_->head_ = head;
+    response_->hasDate_ = hasDate;
+    response_->hasContentLength_ = hasContentLength;
+    response_->stored_ = time(NULL);
+    response_->expires_ = response_->stored_ + lifetime;
+    if (response_->size() > maxSize_) return fail();
+
+    started_ = true;
+    return true;
+}
+
+Boolean ResponseCache::Recording::append(const void* data, Size len) {
+    if (!response_) return false;
+    if (response_->size() + len > maxSize_) return fail();
+
+    response_->body_.append(static_cast<const char*>(data), len);
+    return true;
+}
+
+void ResponseCache::Recording::finish() {
+    if (!response_ || !started_) return;
+
+    cache_->store(response_, vary_);
+    response_ = NULL;
+}
+
+Boolean ResponseCache::Recording::fail() {
+    delete response_;
+    response_ = NULL;
+    return false;
+}
+
+// -- ResponseCache --
+
+ResponseCache::ResponseCache(Size capacity)
+    : capacity_(capacity)
+    , size_(0)
+    , hits_(0)
+    , misses_(0)
+    , evictions_(0) {}
+
+ResponseCache::~ResponseCache() {
+    for (Lru::iterator itr = lru_.begin(); itr != lru_.end(); ++itr) {
+        delete *itr;
+    }
+}
+
+const CachedResponse* ResponseCache::lookup(const Request& req) {
+    if (!isCacheableRequest(req)) return NULL;
+
+    // the client asks for a response from the origin
+    CacheControl cc = parseCacheControl(req.header(LHEADER_CACHE_CONTROL));
+    if (cc.noStore || cc.noCache || !cc.maxAge) {
+        misses_++;
+        return NULL;
+    }
+
+    std::string primary = primaryKey(req);
+    std::map<std::string, Variants>::iterator variants =
+        variants_.find(primary);
+    if (variants == variants_.end()) {
+        misses_++;
+        return NULL;
+    }
+
+    std::map<std::string, Lru::iterator>::iterator entry =
+        entries_.find(variantKey(primary, variants->second.vary, req));
+    if (entry == entries_.end()) {
+        misses_++;
+        return NULL;
+    }
+
+    Lru::iterator itr = entry->second;
+    if (time(NULL) >= (*itr)->expires_) {
+        remove(itr);
+        misses_++;
+        return NULL;
+    }
+
+    lru_.splice(lru_.begin(), lru_, itr);
+    hits_++;
+    return *itr;
+}
+
+ResponseCache::Recording* ResponseCache::record(Request* req) {
+    if (!req) return NULL;
+
+    if (!isCacheableRequest(*req) ||
+        parseCacheControl(req->header(LHEADER_CACHE_CONTROL)).noStore) {
+        delete req;
+        return NULL;
+    }
+    return new Recording(this, req);
+}
+
+void ResponseCache::store(
+    CachedResponse* response,
+    const std::vector<String::CPtr>& vary) {
+    std::map<std::string, Lru::iterator>::iterator entry =
+        entries_.find(response->key_);
+    if (entry != entries_.end()) remove(entry->second);
+
+    // the latest Vary is used for the lookup of the method and URL
+    Variants& variants = variants_[response->primary_];
+    variants.vary = vary;
+    variants.count++;
+
+    lru_.push_front(response);
+    entries_[response->key_] = lru_.begin();
+    size_ += response->size();
+    while (size_ > capacity_ && !lru_.empty()) {
+        remove(--lru_.end());
+        evictions_++;
+    }
+}
+
+void ResponseCache::remove(Lru::iterator itr) {
+    CachedResponse* response = *itr;
+    size_ -= response->size();
+    entries_.erase(response->key_);
+
+    std::map<std::string, Variants>::iterator variants =
+        variants_.find(response->primary_);
+    if (variants != variants_.end() && !--variants->second.count) {
+        variants_.erase(variants);
+    }
+
+    lru_.erase(itr);
+    delete response;
+}
+
+std::string ResponseCache::primaryKey(const Request& req) {
+    std::string key = methodName(req.method())->toStdString();
+    key += ' ';
+    key += req.url()->toStdString();
+    return key;
+}
+
+// the values of the Vary headers follow the primary key line by line,
+// which cannot be confused as header values have no LF
+std::string ResponseCache::variantKey(
+    const std::string& primary,
+    const std::vector<String::CPtr>& vary,
+    const Request& req) {
+    std::string key = primary;
+    for (Size i = 0; i < vary.size(); i++) {
+        String::CPtr value = req.header(vary[i]);
+        key += '\n';
+        if (value) key += value->toStdString();
+    }
+    return key;
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,205 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_RESPONSE_CACHE_H_
+#define LIBNODE_SRC_HTTP_RESPONSE_CACHE_H_
+
+#include <time.h>
+#include <libj/string.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "libnode/http/method.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// a response kept by ResponseCache. the status line and the end-to-end
+// header fields are serialized as they were sent, and the body is
+// the one after compression but before the chunk framing.
+class CachedResponse {
+ public:
+    Int statusCode() const {
+        return statusCode_;
+    }
+
+    // from the status line to the CRLF of the last header field
+    const std::string& head() const {
+        return head_;
+    }
+
+    const std::string& body() const {
+        return body_;
+    }
+
+    Boolean hasDate() const {
+        return hasDate_;
+    }
+
+    Boolean hasContentLength() const {
+        return hasContentLength_;
+    }
+
+    // seconds since it was stored, for the Age header
+    Size age(time_t now) const {
+        return now > stored_ ? now - stored_ : 0;
+    }
+
+    // the memory accounted to the cache
+    Size size() const {
+        return key_.length() + head_.length() + body_.length();
+    }
+
+ private:
+    friend class ResponseCache;
+
+    std::string key_;
+    std::string primary_;
+    Int statusCode_;
+    std::string head_;
+    std::string body_;
+    Boolean hasDate_;
+    Boolean hasContentLength_;
+    time_t stored_;
+    time_t expires_;
+
+    CachedResponse()
+        : statusCode_(0)
+        , hasDate_(false)
+        , hasContentLength_(false)
+        , stored_(0)
+        , expires_(0) {}
+};
+
+// a bounded LRU of whole GET responses in memory,
+// keyed by the URL and the request headers which their Vary names.
+// a response is stored only if its Cache-Control has a positive
+// s-maxage or max-age, and is dropped when that expires.
+class ResponseCache {
+ public:
+    // what the cache reads of a request
+    class Request {
+     public:
+        virtual ~Request() {}
+
+        virtual Method method() const = 0;
+        virtual String::CPtr url() const = 0;
+
+        // 'name' is in lower case
+        virtual String::CPtr header(String::CPtr name) const = 0;
+    };
+
+    // a response being written, which is stored when it ends
+    class Recording {
+     public:
+        ~Recording();
+
+        // 'head' is the serialized status line and end-to-end header
+        // fields. false if the response cannot be cached.
+        Boolean start(
+            Int statusCode,
+            const std::string& head,
+            String::CPtr cacheControl,
+            String::CPtr vary,
+            Boolean hasSetCookie,
+            Boolean hasDate,
+            Boolean hasContentLength);
+
+        // false once the body has grown too large to be cached
+        Boolean append(const void* data, Size len);
+
+        // stores the response unless start() or append() has failed
+        void finish();
+
+     private:
+        friend class ResponseCache;
+
+        ResponseCache* cache_;
+        Request* request_;
+        CachedResponse* response_;
+        Boolean started_;
+        Size maxSize_;
+        std::vector<String::CPtr> vary_;
+
+        Recording(ResponseCache* cache, Request* req);
+
+        // drops the response, and returns false
+        Boolean fail();
+    };
+
+    // at most 'capacity' bytes of responses are kept,
+    // each of which is at most 'capacity' / kMaxEntryRatio
+    explicit ResponseCache(Size capacity);
+
+    ~ResponseCache();
+
+    // the fresh response to 'req', or NULL.
+    // it stays valid until the cache is changed.
+    const CachedResponse* lookup(const Request& req);
+
+    // a Recording for the response to 'req', which takes 'req' over.
+    // NULL if the response is not to be stored.
+    Recording* record(Request* req);
+
+    Size hits() const {
+        return hits_;
+    }
+
+    Size misses() const {
+        return misses_;
+    }
+
+    Size evictions() const {
+        return evictions_;
+    }
+
+    Size entries() const {
+        return entries_.size();
+    }
+
+    Size size() const {
+        return size_;
+    }
+
+ private:
+    static const Size kMaxEntryRatio = 8;
+
+    typedef std::list<CachedResponse*> Lru;
+
+    // the Vary field names of the responses to a method and URL
+    struct Variants {
+        std::vector<String::CPtr> vary;
+        Size count;
+    };
+
+    Size capacity_;
+    Size size_;
+    Size hits_;
+    Size misses_;
+    Size evictions_;
+    Lru lru_;
+    std::map<std::string, Lru::iterator> entries_;
+    std::map<std::string, Variants> variants_;
+
+    void store(
+        CachedResponse* response,
+        const std::vector<String::CPtr>& vary);
+
+    void remove(Lru::iterator itr);
+
+    static std::string primaryKey(const Request& req);
+
+    static std::string variantKey(
+        const std::string& primary,
+        const std::vector<String::CPtr>& vary,
+        const Request& req);
+};
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_RESPONSE_CACHE_H_
@@ -2,13 +2,19 @@
 
 #include <assert.h>
 
+#include <set>
+#include <vector>
+
 #include "libnode/http/server.h"
 
 #include "./parser.h"
+#include "./response_cache.h"
 #include "./server_request_impl.h"
 #include "./server_response_impl.h"
 #include "../net/server_impl.h"
 #include "../net/socket_impl.h"
+#include "../ring_queue.h"
+#include "../uv/timer.h"
 
 namespace libj {
 namespace node {
@@ -16,8 +22,100 @@ namespace http {
 
 class ServerImpl : public FlagMixin, public Server {
  public:
-    static Ptr create() {
-        ServerImpl* httpSrv = new ServerImpl();
+    static Ptr create(JsObject::CPtr options) {
+        LIBJ_STATIC_SYMBOL_DEF(symHighWaterMark,  "highWaterMark");
+        LIBJ_STATIC_SYMBOL_DEF(symLowWaterMark,   "lowWaterMark");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxFreeParsers, "maxFreeParsers");
+        LIBJ_STATIC_SYMBOL_DEF(symFastScan,       "fastScan");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxBodySize,    "maxBodySize");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxHeaderSize,  "maxHeaderSize");
+        LIBJ_STATIC_SYMBOL_DEF(symHeadersTimeout, "headersTimeout");
+        LIBJ_STATIC_SYMBOL_DEF(symReqTimeout,     "requestTimeout");
+        LIBJ_STATIC_SYMBOL_DEF(symCheckInterval,
+                               "connectionsCheckingInterval");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxPipeline,    "maxPipelineDepth");
+        LIBJ_STATIC_SYMBOL_DEF(symKeepAlive,      "keepAliveTimeout");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxRequests,    "maxRequestsPerSocket");
+        LIBJ_STATIC_SYMBOL_DEF(symSendDate,       "sendDate");
+        LIBJ_STATIC_SYMBOL_DEF(symCompression,    "compression");
+        LIBJ_STATIC_SYMBOL_DEF(symCompressLevel,  "compressionLevel");
+        LIBJ_STATIC_SYMBOL_DEF(symCompressMin,    "compressionMinSize");
+        LIBJ_STATIC_SYMBOL_DEF(symCompressOffload,
+                               "compressionOffloadSize");
+        LIBJ_STATIC_SYMBOL_DEF(symResponseCache,  "responseCacheSize");
+
+        ServerImpl* httpSrv = new ServerImpl(options);
+        if (options) {
+            Int high = 0;
+            Int low = 0;
+            to<Int>(options->get(symHighWaterMark), &high);
+            to<Int>(options->get(symLowWaterMark), &low);
+            if (high > 0) {
+                httpSrv->highWaterMark_ = high;
+                httpSrv->lowWaterMark_ = low > 0 ? low : high / 4;
+            }
+
+            Int maxFreeParsers = -1;
+            to<Int>(options->get(symMaxFreeParsers), &maxFreeParsers);
+            if (maxFreeParsers >= 0) Parser::setMaxFree(maxFreeParsers);
+
+            Boolean fastScan = false;
+            to<Boolean>(options->get(symFastScan), &fastScan);
+            httpSrv->fastScan_ = fastScan;
+
+            Int maxBodySize = 0;
+            to<Int>(options->get(symMaxBodySize), &maxBodySize);
+            if (maxBodySize > 0) httpSrv->maxBodySize_ = maxBodySize;
+
+            Int maxHeaderSize = -1;
+            to<Int>(options->get(symMaxHeaderSize), &maxHeaderSize);
+            if (maxHeaderSize >= 0) httpSrv->maxHeaderSize_ = maxHeaderSize;
+
+            Int headersTimeout = -1;
+            Int requestTimeout = -1;
+            Int keepAliveTimeout = -1;
+            Int checkInterval = 0;
+            to<Int>(options->get(symHeadersTimeout), &headersTimeout);
+            to<Int>(options->get(symReqTimeout), &requestTimeout);
+            to<Int>(options->get(symKeepAlive), &keepAliveTimeout);
+            to<Int>(options->get(symCheckInterval), &checkInterval);
+            if (headersTimeout >= 0) httpSrv->headersTimeout_ = headersTimeout;
+            if (requestTimeout >= 0) httpSrv->requestTimeout_ = requestTimeout;
+            if (keepAliveTimeout >= 0)
+                httpSrv->keepAliveTimeout_ = keepAliveTimeout;
+            if (checkInterval > 0) httpSrv->checkInterval_ = checkInterval;
+
+            Int maxRequests = 0;
+            to<Int>(options->get(symMaxRequests), &maxRequests);
+            if (maxRequests > 0) httpSrv->maxRequestsPerSocket_ = maxRequests;
+
+            to<Boolean>(options->get(symSendDate), &httpSrv->sendDate_);
+
+            Int maxPipeline = -1;
+            to<Int>(options->get(symMaxPipeline), &maxPipeline);
+            if (maxPipeline >= 0) httpSrv->maxPipelineDepth_ = maxPipeline;
+
+            Int compressMin = -1;
+            Int compressOffload = -1;
+            to<Boolean>(
+                options->get(symCompression),
+                &httpSrv->compression_);
+            to<Int>(
+                options->get(symCompressLevel),
+                &httpSrv->compressionLevel_);
+            to<Int>(options->get(symCompressMin), &compressMin);
+            to<Int>(options->get(symCompressOffload), &compressOffload);
+            if (compressMin >= 0) httpSrv->compressionMinSize_ = compressMin;
+            if (compressOffload >= 0)
+                httpSrv->compressionOffloadSize_ = compressOffload;
+
+            Int responseCacheSize = 0;
+            to<Int>(options->get(symResponseCache), &responseCacheSize);
+            if (responseCacheSize > 0) {
+                httpSrv->responseCache_ = new ResponseCache(responseCacheSize);
+            }
+        }
+        httpSrv->startCheckingConnections();
         httpSrv->server_->setFlag(net::ServerImpl::ALLOW_HALF_OPEN);
         httpSrv->addListener(
             EVENT_CONNECTION,
@@ -28,11 +126,190 @@ class ServerImpl : public FlagMixin, public Server {
         return Ptr(httpSrv);
     }
 
+    void closeIdleConnections() {
+        std::vector<net::SocketImpl::Ptr> idle;
+        std::set<Connection*>::const_iterator itr = connections_.begin();
+        for (; itr != connections_.end(); ++itr) {
+            Connection* conn = *itr;
+            if (conn->isIdle()) idle.push_back(conn->parser()->socket());
+        }
+        for (Size i = 0; i < idle.size(); i++) {
+            if (idle[i]) idle[i]->destroy();
+        }
+    }
+
+    JsObject::CPtr responseCacheStats() const {
+        LIBJ_STATIC_SYMBOL_DEF(symHits,      "hits");
+        LIBJ_STATIC_SYMBOL_DEF(symMisses,    "misses");
+        LIBJ_STATIC_SYMBOL_DEF(symEvictions, "evictions");
+        LIBJ_STATIC_SYMBOL_DEF(symEntries,   "entries");
+        LIBJ_STATIC_SYMBOL_DEF(symSize,      "size");
+
+        if (!responseCache_) return JsObject::null();
+
+        JsObject::Ptr stats = JsObject::create();
+        stats->put(symHits, responseCache_->hits());
+        stats->put(symMisses, responseCache_->misses());
+        stats->put(symEvictions, responseCache_->evictions());
+        stats->put(symEntries, responseCache_->entries());
+        stats->put(symSize, responseCache_->size());
+        return stats;
+    }
+
+ private:
+    // the state of a connection: the requests which are not answered
+    // yet, the responses which wait for the ones before them,
+    // and what the timer needs to tell an idle connection
+    class Connection : LIBJ_JS_OBJECT(Connection)
+     public:
+        static Ptr create(Parser* parser, Size maxDepth) {
+            return Ptr(new Connection(parser, maxDepth));
+        }
+
+        Parser* parser() const {
+            return parser_;
+        }
+
+        void setParser(Parser* parser) {
+            parser_ = parser;
+        }
+
+        RingQueue<IncomingMessage::Ptr>& incomings() {
+            return incomings_;
+        }
+
+        RingQueue<OutgoingMessage::Ptr>& outgoings() {
+            return outgoings_;
+        }
+
+        // more requests are in flight than the server allows
+        Boolean isFull() const {
+            return maxDepth_ && incomings_.length() > maxDepth_;
+        }
+
+        // no request is being read or answered,
+        // including a connection which has sent nothing yet
+        Boolean isIdle() const {
+            return incomings_.isEmpty() &&
+                parser_ && !parser_->inMessage();
+        }
+
+        // the loop time when the last response finished,
+        // or when the connection was accepted
+        Long idleStart() const {
+            return idleStart_;
+        }
+
+        void setIdleStart(Long idleStart) {
+            idleStart_ = idleStart;
+        }
+
+        // the number of the requests read so far, this one included
+        Size countRequest() {
+            return ++numRequests_;
+        }
+
+     private:
+        JsObject::Ptr obj_;
+        Parser* parser_;
+        Size maxDepth_;
+        Size numRequests_;
+        Long idleStart_;
+        RingQueue<IncomingMessage::Ptr> incomings_;
+        RingQueue<OutgoingMessage::Ptr> outgoings_;
+
+        Connection(Parser* parser, Size maxDepth)
+            : obj_(JsObject::create())
+            , parser_(parser)
+            , maxDepth_(maxDepth)
+            , numRequests_(0)
+            , idleStart_(0) {}
+
+        LIBJ_JS_OBJECT_IMPL(obj_);
+    };
+
+ public:
+    virtual ~ServerImpl() {
+        if (checkTimer_) checkTimer_->close();
+        delete responseCache_;
+    }
+
  private:
     static void freeParser(Parser* parser) {
-        assert(parser);
-        parser->free();
-        delete parser;
+        Parser::release(parser);
+    }
+
+    // answers a request which can not be parsed any further,
+    // and closes the connection once the answer is written
+    static void rejectRequest(net::SocketImpl* socket, const char* response) {
+        OutgoingMessage* msg = socket->httpMessage();
+        if (socket->writable() && (!msg || !msg->headerStored())) {
+            socket->write(String::create(response));
+        }
+        socket->destroySoon();
+    }
+
+    static Long now() {
+        return static_cast<Long>(uv_now(uv_default_loop()));
+    }
+
+    // one timer for all the connections of the server, rather than
+    // one for each socket, which is restarted on every read
+    void startCheckingConnections() {
+        if (!headersTimeout_ && !requestTimeout_ && !keepAliveTimeout_) {
+            return;
+        }
+
+        // an idle connection lives at most twice as long as keepAliveTimeout
+        Size interval = checkInterval_;
+        if (keepAliveTimeout_ && keepAliveTimeout_ < interval) {
+            interval = keepAliveTimeout_;
+        }
+
+        checkTimer_ = new uv::Timer();
+        checkTimer_->setOnTimeout(ServerOnCheckConnections::create(this));
+        checkTimer_->start(interval, interval);
+        checkTimer_->unref();
+    }
+
+    void checkConnections() {
+        static const char timeout[] =
+            "HTTP/1.1 408 Request Timeout\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+
+        Long current = now();
+        std::vector<net::SocketImpl::Ptr> expired;
+        std::vector<net::SocketImpl::Ptr> idle;
+        std::set<Connection*>::const_iterator itr = connections_.begin();
+        for (; itr != connections_.end(); ++itr) {
+            Connection* conn = *itr;
+            Parser* parser = conn->parser();
+            if (!parser) continue;
+
+            Long start = parser->messageStart();
+            if (conn->isIdle() &&
+                keepAliveTimeout_ &&
+                current - conn->idleStart() >=
+                    static_cast<Long>(keepAliveTimeout_)) {
+                idle.push_back(parser->socket());
+            } else if (start &&
+                ((headersTimeout_ &&
+                  !parser->headersComplete() &&
+                  current - start >= static_cast<Long>(headersTimeout_)) ||
+                 (requestTimeout_ &&
+                  current - start >= static_cast<Long>(requestTimeout_)))) {
+                expired.push_back(parser->socket());
+            }
+        }
+
+        // closing a socket removes its connection from connections_
+        for (Size i = 0; i < expired.size(); i++) {
+            if (expired[i]) rejectRequest(&(*expired[i]), timeout);
+        }
+        for (Size i = 0; i < idle.size(); i++) {
+            if (idle[i]) idle[i]->destroy();
+        }
     }
 
     static void httpSocketSetup(net::SocketImpl::Ptr socket) {
@@ -41,12 +318,12 @@ class ServerImpl : public FlagMixin, public Server {
         socket->on(net::Socket::EVENT_DRAIN, onDrain);
     }
 
-    static void abortIncoming(JsArray::Ptr incomings) {
+    static void abortIncoming(Connection::Ptr conn) {
         LIBJ_STATIC_SYMBOL_DEF(EVENT_ABORTED, "aborted");
 
-        while (incomings->length()) {
-            IncomingMessage::Ptr req =
-                toPtr<IncomingMessage>(incomings->shift());
+        RingQueue<IncomingMessage::Ptr>& incomings = conn->incomings();
+        while (!incomings.isEmpty()) {
+            IncomingMessage::Ptr req = incomings.shift();
             req->emit(EVENT_ABORTED);
             req->emit(IncomingMessage::EVENT_CLOSE);
         }
@@ -73,41 +350,46 @@ class ServerImpl : public FlagMixin, public Server {
 
     class SocketOnClose : LIBJ_JS_FUNCTION(SocketOnClose)
      public:
-        static Ptr create(Parser* parser, JsArray::Ptr incomings) {
-            return Ptr(new SocketOnClose(parser, incomings));
+        static Ptr create(ServerImpl* server, Connection::Ptr conn) {
+            return Ptr(new SocketOnClose(server, conn));
         }
 
         Value operator()(JsArray::Ptr args) {
-            freeParser(parser_);
-            parser_ = NULL;
-            abortIncoming(incomings_);
+            Parser* parser = conn_->parser();
+            if (parser) {
+                conn_->setParser(NULL);
+                freeParser(parser);
+            }
+            self_->connections_.erase(&(*conn_));
+            abortIncoming(conn_);
             return libj::Status::OK;
         }
 
      private:
-        Parser* parser_;
-        JsArray::Ptr incomings_;
+        ServerImpl* self_;
+        Connection::Ptr conn_;
 
-        SocketOnClose(Parser* parser, JsArray::Ptr incomings)
-            : parser_(parser)
-            , incomings_(incomings) {}
+        SocketOnClose(ServerImpl* srv, Connection::Ptr conn)
+            : self_(srv)
+            , conn_(conn) {}
     };
 
-    class SocketOnTimeout : LIBJ_JS_FUNCTION(SocketOnTimeout)
+    class ServerOnCheckConnections
+        : LIBJ_JS_FUNCTION(ServerOnCheckConnections)
      public:
-        static Ptr create(net::SocketImpl::Ptr socket) {
-            return Ptr(new SocketOnTimeout(&(*socket)));
+        static Ptr create(ServerImpl* srv) {
+            return Ptr(new ServerOnCheckConnections(srv));
         }
 
         Value operator()(JsArray::Ptr args) {
-            socket_->destroy();
+            self_->checkConnections();
             return libj::Status::OK;
         }
 
      private:
-        net::SocketImpl* socket_;
+        ServerImpl* self_;
 
-        SocketOnTimeout(net::SocketImpl* sock) : socket_(sock) {}
+        ServerOnCheckConnections(ServerImpl* srv) : self_(srv) {}
     };
 
     class SocketOnError : LIBJ_JS_FUNCTION(SocketOnError)
@@ -141,17 +423,24 @@ class ServerImpl : public FlagMixin, public Server {
             ServerImpl* server,
             Parser* parser,
             net::SocketImpl::Ptr socket,
+            Connection::Ptr conn,
             JsFunction::Ptr onClose) {
-            return Ptr(new SocketOnData(server, parser, &(*socket), onClose));
+            return Ptr(new SocketOnData(
+                server, parser, &(*socket), conn, onClose));
         }
 
         Value operator()(JsArray::Ptr args) {
-            LIBJ_STATIC_SYMBOL_DEF(symConnect, "CONNECT");
+            static const char tooLarge[] =
+                "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+                "Connection: close\r\n"
+                "\r\n";
 
             Buffer::CPtr buf = args->getCPtr<Buffer>(0);
             Int bytesParsed = parser_->execute(buf);
             IncomingMessage::Ptr req = parser_->incoming();
-            if (bytesParsed < 0) {
+            if (bytesParsed < 0 && parser_->headerOverflow()) {
+                rejectRequest(socket_, tooLarge);
+            } else if (bytesParsed < 0) {
                 libj::Error::CPtr err =
                     libj::Error::create(libj::Error::ILLEGAL_DATA_FORMAT);
                 socket_->destroy(err);
@@ -161,10 +450,12 @@ class ServerImpl : public FlagMixin, public Server {
                 socket_->removeListener(net::Socket::EVENT_CLOSE, onClose_);
 
                 parser_->finish();
+                self_->connections_.erase(&(*conn_));
+                conn_->setParser(NULL);
                 freeParser(parser_);
                 parser_ = NULL;
 
-                Boolean isConnect = req->method()->equals(symConnect);
+                Boolean isConnect = req->methodCode() == METHOD_CONNECT;
                 String::CPtr event = isConnect ? EVENT_CONNECT : EVENT_UPGRADE;
                 if (self_->listeners(event)->length()) {
                     self_->emit(
@@ -183,16 +474,19 @@ class ServerImpl : public FlagMixin, public Server {
         ServerImpl* self_;
         Parser* parser_;
         net::SocketImpl* socket_;
+        Connection::Ptr conn_;
         JsFunction::Ptr onClose_;
 
         SocketOnData(
             ServerImpl* srv,
             Parser* parser,
             net::SocketImpl* sock,
+            Connection::Ptr conn,
             JsFunction::Ptr onClose)
             : self_(srv)
             , parser_(parser)
             , socket_(sock)
+            , conn_(conn)
             , onClose_(onClose) {}
     };
 
@@ -202,10 +496,9 @@ class ServerImpl : public FlagMixin, public Server {
             ServerImpl* server,
             Parser* parser,
             net::SocketImpl::Ptr socket,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings) {
+            Connection::Ptr conn) {
             return Ptr(new SocketOnEnd(
-                server, parser, &(*socket), incomings, outgoings));
+                server, parser, &(*socket), conn));
         }
 
         Value operator()(JsArray::Ptr args) {
@@ -216,12 +509,10 @@ class ServerImpl : public FlagMixin, public Server {
             }
 
             if (!self_->hasFlag(HTTP_ALLOW_HALF_OPEN)) {
-                abortIncoming(incomings_);
+                abortIncoming(conn_);
                 if (socket_->writable()) socket_->end();
-            } else if (outgoings_->length()) {
-                Size lastIndex = outgoings_->length() - 1;
-                OutgoingMessage::Ptr lastMsg =
-                    outgoings_->getPtr<OutgoingMessage>(lastIndex);
+            } else if (!conn_->outgoings().isEmpty()) {
+                OutgoingMessage::Ptr lastMsg = conn_->outgoings().back();
                 lastMsg->setFlag(OutgoingMessage::LAST);
             } else if (socket_->httpMessage()) {
                 socket_->httpMessage()->setFlag(OutgoingMessage::LAST);
@@ -235,20 +526,17 @@ class ServerImpl : public FlagMixin, public Server {
         ServerImpl* self_;
         Parser* parser_;
         net::SocketImpl* socket_;
-        JsArray::Ptr incomings_;
-        JsArray::Ptr outgoings_;
+        Connection::Ptr conn_;
 
         SocketOnEnd(
             ServerImpl* srv,
             Parser* parser,
             net::SocketImpl* sock,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings)
+            Connection::Ptr conn)
             : self_(srv)
             , parser_(parser)
             , socket_(sock)
-            , incomings_(incomings)
-            , outgoings_(outgoings) {}
+            , conn_(conn) {}
     };
 
     class OutgoingMessageOnFinish : LIBJ_JS_FUNCTION(OutgoingMessageOnFinish)
@@ -256,23 +544,32 @@ class ServerImpl : public FlagMixin, public Server {
         static Ptr create(
             OutgoingMessage::Ptr res,
             net::SocketImpl::Ptr socket,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings) {
+            Connection::Ptr conn) {
             return Ptr(new OutgoingMessageOnFinish(
-                &(*res), socket, incomings, outgoings));
+                &(*res), socket, conn));
         }
 
         Value operator()(JsArray::Ptr args) {
-            incomings_->shift();
+            RingQueue<IncomingMessage::Ptr>& incomings =
+                conn_->incomings();
+            RingQueue<OutgoingMessage::Ptr>& outgoings =
+                conn_->outgoings();
+
+            if (!incomings.isEmpty()) incomings.shift();
+            if (incomings.isEmpty()) conn_->setIdleStart(now());
             res_->detachSocket(socket_);
             if (res_->hasFlag(OutgoingMessage::LAST)) {
                 socket_->destroySoon();
             } else {
-                OutgoingMessage::Ptr msg =
-                    toPtr<OutgoingMessage>(outgoings_->shift());
-                if (msg) {
+                if (!outgoings.isEmpty()) {
+                    OutgoingMessage::Ptr msg = outgoings.shift();
                     msg->assignSocket(msg, socket_);
                 }
+
+                Parser* parser = socket_->parser();
+                if (parser && parser->paused() && !conn_->isFull()) {
+                    parser->resume();
+                }
             }
             return libj::Status::OK;
         }
@@ -280,18 +577,68 @@ class ServerImpl : public FlagMixin, public Server {
      private:
         OutgoingMessage* res_;
         net::SocketImpl::Ptr socket_;
-        JsArray::Ptr incomings_;
-        JsArray::Ptr outgoings_;
+        Connection::Ptr conn_;
 
         OutgoingMessageOnFinish(
             OutgoingMessage* res,
             net::SocketImpl::Ptr socket,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings)
+            Connection::Ptr conn)
             : res_(res)
             , socket_(socket)
-            , incomings_(incomings)
-            , outgoings_(outgoings) {}
+            , conn_(conn) {}
+    };
+
+    class IncomingOnBodyTooLarge : LIBJ_JS_FUNCTION(IncomingOnBodyTooLarge)
+     public:
+        static Ptr create(OutgoingMessage::Ptr res) {
+            return Ptr(new IncomingOnBodyTooLarge(res));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            LIBJ_STATIC_SYMBOL_DEF(symClose, "close");
+
+            if (res_->hasFlag(OutgoingMessage::FINISHED)) {
+                return libj::Status::OK;
+            }
+
+            if (!res_->headerStored()) {
+                JsObject::Ptr headers = JsObject::create();
+                headers->put(HEADER_CONNECTION, symClose);
+                headers->put(HEADER_CONTENT_LENGTH, String::valueOf(0));
+                res_->writeHead(
+                    Status::REQUEST_ENTITY_TOO_LARGE,
+                    String::null(),
+                    headers);
+            }
+            res_->end(UNDEFINED, Buffer::NONE);
+            return libj::Status::OK;
+        }
+
+     private:
+        OutgoingMessage::Ptr res_;
+
+        IncomingOnBodyTooLarge(OutgoingMessage::Ptr res) : res_(res) {}
+    };
+
+    // the request as the response cache reads it
+    class CacheRequest : public ResponseCache::Request {
+     public:
+        CacheRequest(IncomingMessage::Ptr in) : in_(in) {}
+
+        Method method() const {
+            return in_->methodCode();
+        }
+
+        String::CPtr url() const {
+            return in_->url();
+        }
+
+        String::CPtr header(String::CPtr name) const {
+            return in_->getHeader(name);
+        }
+
+     private:
+        IncomingMessage::Ptr in_;
     };
 
     class ParserOnIncoming : LIBJ_JS_FUNCTION(ParserOnIncoming)
@@ -299,15 +646,12 @@ class ServerImpl : public FlagMixin, public Server {
         static Ptr create(
             ServerImpl* server,
             net::SocketImpl::Ptr socket,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings) {
-            return Ptr(new ParserOnIncoming(
-                server, socket, incomings, outgoings));
+            Connection::Ptr conn) {
+            return Ptr(new ParserOnIncoming(server, socket, conn));
         }
 
         Value operator()(JsArray::Ptr args) {
             LIBJ_STATIC_SYMBOL_DEF(EVENT_FINISH, "finish");
-            LIBJ_STATIC_SYMBOL_DEF(symV11,       "1.1");
             LIBJ_STATIC_SYMBOL_DEF(symExpect,    "expect");
             LIBJ_STATIC_SYMBOL_DEF(symContExp,   "100-continue");
 
@@ -315,28 +659,86 @@ class ServerImpl : public FlagMixin, public Server {
             Boolean shouldKeepAlive = false;
             to<Boolean>(args->get(1), &shouldKeepAlive);
 
+            // the last request allowed on the connection is answered
+            // with 'Connection: close', and any after it with 503
+            Size maxRequests = self_->maxRequestsPerSocket_;
+            Size numRequests = conn_->countRequest();
+            if (maxRequests && numRequests >= maxRequests)
+                shouldKeepAlive = false;
+
             OutgoingMessage::Ptr out = OutgoingMessage::create();
             out->setFlag(OutgoingMessage::SERVER_RESPONSE);
-            incomings_->push(in);
-            if (shouldKeepAlive)
+            if (self_->sendDate_) out->setFlag(OutgoingMessage::SEND_DATE);
+            if (self_->compression_) {
+                out->setCompression(
+                    Compressor::negotiate(
+                        in->getHeader(LHEADER_ACCEPT_ENCODING)),
+                    self_->compressionLevel_,
+                    self_->compressionMinSize_,
+                    self_->compressionOffloadSize_);
+            }
+            if (in->methodCode() == METHOD_HEAD) {
+                out->unsetFlag(OutgoingMessage::HAS_BODY);
+            }
+            conn_->incomings().push(in);
+            if (shouldKeepAlive) {
                 out->setFlag(OutgoingMessage::SHOULD_KEEP_ALIVE);
+                out->setKeepAliveTimeout(self_->keepAliveTimeout_);
+            } else {
+                out->unsetFlag(OutgoingMessage::SHOULD_KEEP_ALIVE);
+            }
 
             OutgoingMessage* httpMessage = socket_->httpMessage();
             if (httpMessage) {
-                outgoings_->push(out);
+                conn_->outgoings().push(out);
             } else {
                 out->assignSocket(out, socket_);
             }
 
+            // read no more requests until the responses catch up
+            Parser* parser = socket_->parser();
+            if (parser && conn_->isFull()) parser->pause();
+
             out->on(
                 EVENT_FINISH,
-                OutgoingMessageOnFinish::create(
-                    out, socket_, incomings_, outgoings_));
+                OutgoingMessageOnFinish::create(out, socket_, conn_));
+
+            in->setMaxBodySize(self_->maxBodySize_);
+            in->setOnBodyTooLarge(IncomingOnBodyTooLarge::create(out));
+
+            if (maxRequests && numRequests > maxRequests) {
+                LIBJ_STATIC_SYMBOL_DEF(symClose, "close");
+
+                JsObject::Ptr headers = JsObject::create();
+                headers->put(HEADER_CONNECTION, symClose);
+                headers->put(HEADER_CONTENT_LENGTH, String::valueOf(0));
+                out->writeHead(
+                    Status::SERVICE_UNAVAILABLE,
+                    String::null(),
+                    headers);
+                out->end(UNDEFINED, Buffer::NONE);
+
+                // any body is parsed and dropped, not taken as a request
+                return false;
+            }
+
+            // a fresh response in the cache goes out without the listeners
+            ResponseCache* cache = self_->responseCache_;
+            if (cache && in->methodCode() == METHOD_GET) {
+                CacheRequest cacheReq(in);
+                const CachedResponse* cached = cache->lookup(cacheReq);
+                if (cached) {
+                    out->endCached(*cached);
+                    return false;
+                }
+                out->setRecording(cache->record(new CacheRequest(in)));
+            }
 
             ServerRequest::Ptr req = ServerRequestImpl::create(in);
             ServerResponse::Ptr res = ServerResponseImpl::create(out);
             String::CPtr expectHeader = in->getHeader(symExpect);
-            if (in->httpVersion()->equals(symV11) &&
+            if (in->httpVersionMajor() == 1 &&
+                in->httpVersionMinor() == 1 &&
                 expectHeader &&
                 expectHeader->toLowerCase()->equals(symContExp)) {
                 out->setFlag(OutgoingMessage::EXPECT_CONTINUE);
@@ -355,18 +757,15 @@ class ServerImpl : public FlagMixin, public Server {
      private:
         ServerImpl* self_;
         net::SocketImpl::Ptr socket_;
-        JsArray::Ptr incomings_;
-        JsArray::Ptr outgoings_;
+        Connection::Ptr conn_;
 
         ParserOnIncoming(
             ServerImpl* srv,
             net::SocketImpl::Ptr sock,
-            JsArray::Ptr incomings,
-            JsArray::Ptr outgoings)
+            Connection::Ptr conn)
             : self_(srv)
             , socket_(sock)
-            , incomings_(incomings)
-            , outgoings_(outgoings) {}
+            , conn_(conn) {}
     };
 
     class ServerOnConnection : LIBJ_JS_FUNCTION(ServerOnConnection)
@@ -379,29 +778,26 @@ class ServerImpl : public FlagMixin, public Server {
             net::SocketImpl::Ptr socket = toPtr<net::SocketImpl>(args->get(0));
             assert(socket);
 
-            JsArray::Ptr incomings = JsArray::create();
-            JsArray::Ptr outgoings = JsArray::create();
-
             httpSocketSetup(socket);
 
-#if 0
-            socket->setTimeout(2 * 60 * 1000);
-            socket->once(
-                net::Socket::EVENT_TIMEOUT,
-                SocketOnTimeout::create(socket));
-#endif
-
             Size maxHeaders;
             if (self_->maxHeadersCount_) {
                 maxHeaders = self_->maxHeadersCount_;
             } else {
                 maxHeaders = 2000;
             }
-            Parser* parser = new Parser(HTTP_REQUEST, socket, maxHeaders);
+            Parser* parser = Parser::create(HTTP_REQUEST, socket, maxHeaders);
+            parser->setWaterMarks(self_->highWaterMark_, self_->lowWaterMark_);
+            parser->setFastScan(self_->fastScan_);
+            parser->setMaxHeaderSize(self_->maxHeaderSize_);
             socket->setParser(parser);
 
-            JsFunction::Ptr socketOnClose =
-                SocketOnClose::create(parser, incomings);
+            Connection::Ptr conn =
+                Connection::create(parser, self_->maxPipelineDepth_);
+            conn->setIdleStart(now());
+            self_->connections_.insert(&(*conn));
+
+            JsFunction::Ptr socketOnClose = SocketOnClose::create(self_, conn);
             socket->addListener(
                 EVENT_ERROR,
                 SocketOnError::create(self_, socket));
@@ -411,14 +807,14 @@ class ServerImpl : public FlagMixin, public Server {
 
             socket->setOnData(
                 SocketOnData::create(
-                    self_, parser, socket, socketOnClose));
+                    self_, parser, socket, conn, socketOnClose));
             socket->setOnEnd(
                 SocketOnEnd::create(
-                    self_, parser, socket, incomings, outgoings));
+                    self_, parser, socket, conn));
 
             parser->setOnIncoming(
                 ParserOnIncoming::create(
-                    self_, socket, incomings, outgoings));
+                    self_, socket, conn));
             return libj::Status::OK;
         }
 
@@ -452,10 +848,47 @@ class ServerImpl : public FlagMixin, public Server {
  private:
     net::ServerImpl::Ptr server_;
     Size maxHeadersCount_;
-
-    ServerImpl()
-        : server_(net::ServerImpl::create())
-        , maxHeadersCount_(0) {}
+    Size highWaterMark_;
+    Size lowWaterMark_;
+    Boolean fastScan_;
+    Size maxBodySize_;
+    Size maxHeaderSize_;
+    Size headersTimeout_;
+    Size requestTimeout_;
+    Size checkInterval_;
+    Size maxPipelineDepth_;
+    Size keepAliveTimeout_;
+    Size maxRequestsPerSocket_;
+    Boolean sendDate_;
+    Boolean compression_;
+    Int compressionLevel_;
+    Size compressionMinSize_;
+    Size compressionOffloadSize_;
+    ResponseCache* responseCache_;
+    uv::Timer* checkTimer_;
+    std::set<Connection*> connections_;
+
+    ServerImpl(JsObject::CPtr options)
+        : server_(net::ServerImpl::create(options))
+        , maxHeadersCount_(0)
+        , highWaterMark_(0)
+        , lowWaterMark_(0)
+        , fastScan_(false)
+        , maxBodySize_(1024 * 1024)
+        , maxHeaderSize_(16 * 1024)
+        , headersTimeout_(60 * 1000)
+        , requestTimeout_(5 * 60 * 1000)
+        , checkInterval_(30 * 1000)
+        , maxPipelineDepth_(32)
+        , keepAliveTimeout_(5 * 1000)
+        , maxRequestsPerSocket_(0)
+        , sendDate_(true)
+        , compression_(false)
+        , compressionLevel_(-1)
+        , compressionMinSize_(1024)
+        , compressionOffloadSize_(0)
+        , responseCache_(NULL)
+        , checkTimer_(NULL) {}
 
     LIBNODE_NET_SERVER_IMPL(server_);
 };
@@ -466,8 +899,8 @@ LIBJ_SYMBOL_DEF(Server::EVENT_CONNECT,        "connect");
 LIBJ_SYMBOL_DEF(Server::EVENT_UPGRADE,        "upgrade");
 LIBJ_SYMBOL_DEF(Server::EVENT_CLIENT_ERROR,   "clientError");
 
-Server::Ptr Server::create() {
-    return ServerImpl::create();
+Server::Ptr Server::create(JsObject::CPtr options) {
+    return ServerImpl::create(options);
 }
 
 }  // namespace http
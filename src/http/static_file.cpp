@@ -0,0 +1,618 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <libj/js_array.h>
+
+#include <string>
+
+#include "libnode/fs.h"
+#include "libnode/http.h"
+#include "libnode/url.h"
+
+#include "./date_cache.h"
+#include "./static_file.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+// -- mimeType --
+
+struct MimeType {
+    const char* ext;
+    const char* type;
+};
+
+// sorted by the extension for bsearch
+static const MimeType kMimeTypes[] = {
+    { "avif",  "image/avif" },
+    { "bmp",   "image/bmp" },
+    { "css",   "text/css; charset=UTF-8" },
+    { "csv",   "text/csv; charset=UTF-8" },
+    { "eot",   "application/vnd.ms-fontobject" },
+    { "gif",   "image/gif" },
+    { "gz",    "application/gzip" },
+    { "htm",   "text/html; charset=UTF-8" },
+    { "html",  "text/html; charset=UTF-8" },
+    { "ico",   "image/x-icon" },
+    { "jpeg",  "image/jpeg" },
+    { "jpg",   "image/jpeg" },
+    { "js",    "application/javascript; charset=UTF-8" },
+    { "json",  "application/json; charset=UTF-8" },
+    { "map",   "application/json; charset=UTF-8" },
+    { "md",    "text/markdown; charset=UTF-8" },
+    { "mjs",   "application/javascript; charset=UTF-8" },
+    { "mp3",   "audio/mpeg" },
+    { "mp4",   "video/mp4" },
+    { "ogg",   "audio/ogg" },
+    { "otf",   "font/otf" },
+    { "pdf",   "application/pdf" },
+    { "png",   "image/png" },
+    { "svg",   "image/svg+xml" },
+    { "tar",   "application/x-tar" },
+    { "ttf",   "font/ttf" },
+    { "txt",   "text/plain; charset=UTF-8" },
+    { "wasm",  "application/wasm" },
+    { "wav",   "audio/wav" },
+    { "webm",  "video/webm" },
+    { "webp",  "image/webp" },
+    { "woff",  "font/woff" },
+    { "woff2", "font/woff2" },
+    { "xml",   "application/xml; charset=UTF-8" },
+    { "zip",   "application/zip" },
+};
+
+static const Size kNumMimeTypes = sizeof(kMimeTypes) / sizeof(MimeType);
+
+static int compareMimeType(const void* key, const void* elem) {
+    return strcmp(
+        static_cast<const char*>(key),
+        static_cast<const MimeType*>(elem)->ext);
+}
+
+Symbol::CPtr mimeType(String::CPtr path) {
+    LIBJ_STATIC_SYMBOL_DEF(symOctetStream, "application/octet-stream");
+
+    static Symbol::CPtr types[kNumMimeTypes];
+
+    if (!path) return symOctetStream;
+
+    Size len = path->length();
+    Size dot = len;
+    for (Size i = len; i > 0; i--) {
+        Char c = path->charAt(i - 1);
+        if (c == '.') {
+            dot = i - 1;
+            break;
+        } else if (c == '/') {
+            break;
+        }
+    }
+
+    char ext[8];
+    Size extLen = len - dot - (dot < len ? 1 : 0);
+    if (!extLen || extLen >= sizeof(ext)) return symOctetStream;
+
+    for (Size i = 0; i < extLen; i++) {
+        Char c = path->charAt(dot + 1 + i);
+        if (c & ~0x7f) return symOctetStream;
+
+        ext[i] = static_cast<char>(tolower(c));
+    }
+    ext[extLen] = '\0';
+
+    const MimeType* found = static_cast<const MimeType*>(bsearch(
+        ext,
+        kMimeTypes,
+        kNumMimeTypes,
+        sizeof(MimeType),
+        compareMimeType));
+    if (!found) return symOctetStream;
+
+    Size index = found - kMimeTypes;
+    if (!types[index]) types[index] = Symbol::create(found->type);
+    return types[index];
+}
+
+// -- safePath --
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return -1;
+    }
+}
+
+String::CPtr safePath(String::CPtr pathname) {
+    if (!pathname) return String::null();
+
+    std::string src = pathname->toStdString();
+    if (src.empty() || src[0] != '/') return String::null();
+
+    std::string path;
+    for (Size i = 0; i < src.length(); i++) {
+        char c = src[i];
+        if (c == '%') {
+            if (i + 2 >= src.length()) return String::null();
+
+            int hi = hexValue(src[i + 1]);
+            int lo = hexValue(src[i + 2]);
+            if (hi < 0 || lo < 0) return String::null();
+
+            c = static_cast<char>((hi << 4) | lo);
+            i += 2;
+        }
+        if (c == '\0') return String::null();
+
+        path += c;
+    }
+
+    Size start = 0;
+    while (start < path.length()) {
+        Size end = path.find('/', start);
+        if (end == std::string::npos) end = path.length();
+
+        if (!path.compare(start, end - start, "..")) return String::null();
+
+        start = end + 1;
+    }
+    return String::create(path.data(), String::UTF8, path.length());
+}
+
+// -- entityTag --
+
+std::string entityTag(Long mtime, Size size) {
+    char buf[48];
+    int len = snprintf(
+        buf,
+        sizeof(buf),
+        "\"%llx-%llx\"",
+        static_cast<unsigned long long>(mtime),
+        static_cast<unsigned long long>(size));
+    return std::string(buf, len);
+}
+
+static std::string opaqueTag(const std::string& tag) {
+    if (!tag.compare(0, 2, "W/")) {
+        return tag.substr(2);
+    } else {
+        return tag;
+    }
+}
+
+Boolean etagMatches(String::CPtr ifNoneMatch, const std::string& etag) {
+    if (!ifNoneMatch) return false;
+
+    std::string list = ifNoneMatch->toStdString();
+    std::string tag = opaqueTag(etag);
+    Size start = 0;
+    while (start < list.length()) {
+        Size end = list.find(',', start);
+        if (end == std::string::npos) end = list.length();
+
+        Size first = list.find_first_not_of(" \t", start);
+        Size last = list.find_last_not_of(" \t", end - 1);
+        if (first < end && last != std::string::npos && last >= first) {
+            std::string candidate = list.substr(first, last - first + 1);
+            if (candidate == "*" || opaqueTag(candidate) == tag) return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// -- parseRange --
+
+static Boolean parseSize(const std::string& str, Size* n) {
+    if (str.empty()) return false;
+
+    Size value = 0;
+    for (Size i = 0; i < str.length(); i++) {
+        if (!isdigit(static_cast<unsigned char>(str[i]))) return false;
+
+        Size next = value * 10 + (str[i] - '0');
+        if (next / 10 != value) return false;
+
+        value = next;
+    }
+    *n = value;
+    return true;
+}
+
+RangeResult parseRange(
+    String::CPtr range,
+    Size size,
+    Size* first,
+    Size* last) {
+    if (!range || !first || !last) return RANGE_NONE;
+
+    std::string spec = range->toStdString();
+    if (spec.compare(0, 6, "bytes=")) return RANGE_NONE;
+
+    std::string packed;
+    for (Size i = 6; i < spec.length(); i++) {
+        if (spec[i] != ' ' && spec[i] != '\t') packed += spec[i];
+    }
+    spec = packed;
+    if (spec.find(',') != std::string::npos) return RANGE_NONE;
+
+    Size dash = spec.find('-');
+    if (dash == std::string::npos) return RANGE_NONE;
+
+    if (dash == 0) {
+        // the last N bytes
+        Size suffix;
+        if (!parseSize(spec.substr(1), &suffix)) return RANGE_NONE;
+        if (!suffix || !size) return RANGE_UNSATISFIABLE;
+
+        *first = suffix < size ? size - suffix : 0;
+        *last = size - 1;
+        return RANGE_SATISFIABLE;
+    }
+
+    Size from;
+    if (!parseSize(spec.substr(0, dash), &from)) return RANGE_NONE;
+
+    // up to the end of the file if the last byte is omitted
+    Size until = size;
+    if (dash + 1 < spec.length()) {
+        if (!parseSize(spec.substr(dash + 1), &until)) return RANGE_NONE;
+        if (until < from) return RANGE_NONE;
+    }
+    if (from >= size) return RANGE_UNSATISFIABLE;
+
+    *first = from;
+    *last = until < size ? until : size - 1;
+    return RANGE_SATISFIABLE;
+}
+
+// -- serveStatic --
+
+static Boolean endsWithSlash(String::CPtr str) {
+    Size len = str->length();
+    return len && str->charAt(len - 1) == '/';
+}
+
+static void sendStatus(ServerResponse::Ptr res, Int code) {
+    LIBJ_STATIC_SYMBOL_DEF(symTextPlain, "text/plain; charset=UTF-8");
+
+    String::CPtr msg = Status::create(code)->message();
+    res->setHeader(HEADER_CONTENT_TYPE, symTextPlain);
+    res->setHeader(HEADER_CONTENT_LENGTH, String::valueOf(msg->length()));
+    res->writeHead(code);
+    res->end(msg);
+}
+
+// the file can be closed by the end of sendFile or by the socket closing
+// before it, whichever comes first
+class CloseFile : LIBJ_JS_FUNCTION(CloseFile)
+ public:
+    CloseFile(int fd) : fd_(fd), closed_(false) {}
+
+    Value operator()(JsArray::Ptr args) {
+        if (!closed_) {
+            closed_ = true;
+            fs::close(fd_, JsFunction::null());
+        }
+        return libj::Status::OK;
+    }
+
+ private:
+    int fd_;
+    Boolean closed_;
+};
+
+class AfterOpen : LIBJ_JS_FUNCTION(AfterOpen)
+ public:
+    AfterOpen(
+        ServerResponse::Ptr res,
+        Int statusCode,
+        Size offset,
+        Size length)
+        : res_(res)
+        , statusCode_(statusCode)
+        , offset_(offset)
+        , length_(length) {}
+
+    Value operator()(JsArray::Ptr args) {
+        Error::CPtr err = args->getCPtr<Error>(0);
+        int fd = -1;
+        if (err || !to<int>(args->get(1), &fd)) {
+            // the file was removed after stat
+            res_->removeHeader(HEADER_ETAG);
+            res_->removeHeader(HEADER_LAST_MODIFIED);
+            res_->removeHeader(HEADER_CONTENT_RANGE);
+            sendStatus(res_, Status::NOT_FOUND);
+            return libj::Status::OK;
+        }
+
+        CloseFile::Ptr closeFile(new CloseFile(fd));
+        res_->once(ServerResponse::EVENT_CLOSE, closeFile);
+        // sendFile() writes the implicit header of 200 by itself,
+        // which keeps the file from being compressed
+        if (statusCode_ != Status::OK) res_->writeHead(statusCode_);
+        res_->sendFile(fd, offset_, length_, closeFile);
+        res_->end();
+        return libj::Status::OK;
+    }
+
+ private:
+    ServerResponse::Ptr res_;
+    Int statusCode_;
+    Size offset_;
+    Size length_;
+};
+
+class AfterStat : LIBJ_JS_FUNCTION(AfterStat)
+ public:
+    AfterStat(
+        ServerRequest::Ptr req,
+        ServerResponse::Ptr res,
+        String::CPtr path,
+        String::CPtr pathname,
+        String::CPtr cacheControl,
+        Boolean etag,
+        Boolean lastModified)
+        : req_(req)
+        , res_(res)
+        , path_(path)
+        , pathname_(pathname)
+        , cacheControl_(cacheControl)
+        , etag_(etag)
+        , lastModified_(lastModified) {}
+
+    Value operator()(JsArray::Ptr args) {
+        LIBJ_STATIC_SYMBOL_DEF(symBytes, "bytes");
+
+        Error::CPtr err = args->getCPtr<Error>(0);
+        fs::Stats::CPtr stats = args->getCPtr<fs::Stats>(1);
+        Long mode = 0;
+        Long size = 0;
+        Long mtime = 0;
+        if (err || !stats ||
+            !to<Long>(stats->get(fs::STAT_MODE), &mode) ||
+            !to<Long>(stats->get(fs::STAT_SIZE), &size) ||
+            !to<Long>(stats->get(fs::STAT_MTIME), &mtime)) {
+            sendStatus(res_, Status::NOT_FOUND);
+            return libj::Status::OK;
+        }
+
+        if (S_ISDIR(mode)) {
+            if (endsWithSlash(pathname_)) {
+                sendStatus(res_, Status::NOT_FOUND);
+            } else {
+                res_->setHeader(HEADER_LOCATION, pathname_->concat(
+                    String::create("/")));
+                sendStatus(res_, Status::MOVED_PERMANENTLY);
+            }
+            return libj::Status::OK;
+        } else if (!S_ISREG(mode)) {
+            sendStatus(res_, Status::NOT_FOUND);
+            return libj::Status::OK;
+        }
+
+        std::string etag = entityTag(mtime, size);
+        std::string lastModified = httpDate(mtime);
+        res_->setHeader(HEADER_ACCEPT_RANGES, symBytes);
+        if (etag_) {
+            res_->setHeader(HEADER_ETAG, String::create(etag.c_str()));
+        }
+        if (lastModified_) {
+            res_->setHeader(
+                HEADER_LAST_MODIFIED,
+                String::create(lastModified.c_str()));
+        }
+        if (cacheControl_) {
+            res_->setHeader(HEADER_CACHE_CONTROL, cacheControl_);
+        }
+
+        // the file is not even opened for a conditional hit
+        JsObject::CPtr headers = req_->headers();
+        if (notModified(headers, etag, mtime)) {
+            res_->writeHead(Status::NOT_MODIFIED);
+            res_->end();
+            return libj::Status::OK;
+        }
+
+        Int statusCode = Status::OK;
+        Size first = 0;
+        Size last = size ? size - 1 : 0;
+        Size length = size;
+        String::CPtr range = headers->getCPtr<String>(LHEADER_RANGE);
+        if (range && rangeApplies(headers, etag, lastModified)) {
+            switch (parseRange(range, size, &first, &last)) {
+            case RANGE_SATISFIABLE:
+                statusCode = Status::PARTIAL_CONTENT;
+                length = last - first + 1;
+                res_->setHeader(
+                    HEADER_CONTENT_RANGE,
+                    contentRange(first, last, size));
+                break;
+            case RANGE_UNSATISFIABLE:
+                res_->setHeader(
+                    HEADER_CONTENT_RANGE,
+                    String::create("bytes */")->concat(
+                        String::valueOf(size)));
+                sendStatus(res_, Status::REQUESTED_RANGE_NOT_SATISFIABLE);
+                return libj::Status::OK;
+            default:
+                first = 0;
+                break;
+            }
+        }
+
+        res_->setHeader(HEADER_CONTENT_TYPE, mimeType(path_));
+        res_->setHeader(HEADER_CONTENT_LENGTH, String::valueOf(length));
+        if (req_->methodCode() == METHOD_HEAD || !length) {
+            res_->writeHead(statusCode);
+            res_->end();
+        } else {
+            AfterOpen::Ptr afterOpen(
+                new AfterOpen(res_, statusCode, first, length));
+            fs::open(path_, fs::R, afterOpen);
+        }
+        return libj::Status::OK;
+    }
+
+ private:
+    ServerRequest::Ptr req_;
+    ServerResponse::Ptr res_;
+    String::CPtr path_;
+    String::CPtr pathname_;
+    String::CPtr cacheControl_;
+    Boolean etag_;
+    Boolean lastModified_;
+
+    // If-Modified-Since is ignored when If-None-Match is sent
+    Boolean notModified(
+        JsObject::CPtr headers,
+        const std::string& etag,
+        Long mtime) {
+        String::CPtr ifNoneMatch =
+            headers->getCPtr<String>(LHEADER_IF_NONE_MATCH);
+        if (ifNoneMatch) return etag_ && etagMatches(ifNoneMatch, etag);
+
+        String::CPtr ifModifiedSince =
+            headers->getCPtr<String>(LHEADER_IF_MODIFIED_SINCE);
+        time_t since;
+        return lastModified_ && ifModifiedSince &&
+            parseHttpDate(ifModifiedSince->toStdString(), &since) &&
+            mtime <= since;
+    }
+
+    // If-Range is either an entity tag or the exact Last-Modified
+    Boolean rangeApplies(
+        JsObject::CPtr headers,
+        const std::string& etag,
+        const std::string& lastModified) {
+        String::CPtr ifRange = headers->getCPtr<String>(LHEADER_IF_RANGE);
+        if (!ifRange) return true;
+
+        std::string validator = ifRange->toStdString();
+        if (!validator.compare(0, 1, "\"") ||
+            !validator.compare(0, 2, "W/")) {
+            return etag_ && validator == etag;
+        } else {
+            return lastModified_ && validator == lastModified;
+        }
+    }
+
+    static String::CPtr contentRange(Size first, Size last, Size size) {
+        char buf[80];
+        snprintf(buf, sizeof(buf), "bytes %zu-%zu/%zu", first, last, size);
+        return String::create(buf);
+    }
+};
+
+class ServeStatic : LIBJ_JS_FUNCTION(ServeStatic)
+ public:
+    ServeStatic(
+        String::CPtr root,
+        String::CPtr index,
+        String::CPtr cacheControl,
+        Boolean etag,
+        Boolean lastModified)
+        : root_(root)
+        , index_(index)
+        , cacheControl_(cacheControl)
+        , etag_(etag)
+        , lastModified_(lastModified) {}
+
+    Value operator()(JsArray::Ptr args) {
+        LIBJ_STATIC_SYMBOL_DEF(symAllow, "GET, HEAD");
+
+        ServerRequest::Ptr req = args->getPtr<ServerRequest>(0);
+        ServerResponse::Ptr res = args->getPtr<ServerResponse>(1);
+        if (!req || !res) return libj::Status::OK;
+
+        Method method = req->methodCode();
+        if (method != METHOD_GET && method != METHOD_HEAD) {
+            res->setHeader(HEADER_ALLOW, symAllow);
+            sendStatus(res, Status::METHOD_NOT_ALLOWED);
+            return libj::Status::OK;
+        }
+
+        JsObject::Ptr url = url::parse(req->url());
+        String::CPtr pathname =
+            url ? url->getCPtr<String>(url::PATHNAME) : String::null();
+        String::CPtr path = safePath(pathname);
+        if (!path) {
+            sendStatus(res, Status::FORBIDDEN);
+            return libj::Status::OK;
+        }
+
+        if (endsWithSlash(path)) {
+            if (!index_ || index_->isEmpty()) {
+                sendStatus(res, Status::NOT_FOUND);
+                return libj::Status::OK;
+            }
+            path = path->concat(index_);
+        }
+        path = root_->concat(path);
+
+        AfterStat::Ptr afterStat(new AfterStat(
+            req,
+            res,
+            path,
+            pathname,
+            cacheControl_,
+            etag_,
+            lastModified_));
+        fs::stat(path, afterStat);
+        return libj::Status::OK;
+    }
+
+ private:
+    String::CPtr root_;
+    String::CPtr index_;
+    String::CPtr cacheControl_;
+    Boolean etag_;
+    Boolean lastModified_;
+};
+
+JsFunction::Ptr serveStatic(String::CPtr root, JsObject::CPtr options) {
+    LIBJ_STATIC_SYMBOL_DEF(symIndex,        "index");
+    LIBJ_STATIC_SYMBOL_DEF(symMaxAge,       "maxAge");
+    LIBJ_STATIC_SYMBOL_DEF(symEtag,         "etag");
+    LIBJ_STATIC_SYMBOL_DEF(symLastModified, "lastModified");
+
+    if (!root) return JsFunction::null();
+
+    String::CPtr index = String::create("index.html");
+    Int maxAge = 0;
+    Boolean etag = true;
+    Boolean lastModified = true;
+    if (options) {
+        Value v = options->get(symIndex);
+        if (!v.isUndefined()) index = toCPtr<String>(v);
+        to<Int>(options->get(symMaxAge), &maxAge);
+        to<Boolean>(options->get(symEtag), &etag);
+        to<Boolean>(options->get(symLastModified), &lastModified);
+    }
+
+    // the request path begins with '/'
+    while (endsWithSlash(root)) {
+        root = root->substring(0, root->length() - 1);
+    }
+
+    String::CPtr cacheControl = String::null();
+    if (maxAge >= 0) {
+        cacheControl = String::create("public, max-age=")->concat(
+            String::valueOf(maxAge));
+    }
+    return ServeStatic::Ptr(new ServeStatic(
+        root, index, cacheControl, etag, lastModified));
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
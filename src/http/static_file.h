@@ -0,0 +1,49 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_STATIC_FILE_H_
+#define LIBNODE_SRC_HTTP_STATIC_FILE_H_
+
+#include <libj/symbol.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// the Content-Type for the extension of 'path',
+// or 'application/octet-stream' if it is not in the table
+Symbol::CPtr mimeType(String::CPtr path);
+
+// the decoded request path, which is safe to append to the root.
+// null if it is malformed, contains NUL or climbs up with '..'.
+String::CPtr safePath(String::CPtr pathname);
+
+// a strong validator derived from stat, as nginx does:
+// "<mtime in hex>-<size in hex>"
+std::string entityTag(Long mtime, Size size);
+
+// whether 'etag' is in the list of If-None-Match.
+// the comparison is weak, so W/ prefixes are ignored.
+Boolean etagMatches(String::CPtr ifNoneMatch, const std::string& etag);
+
+enum RangeResult {
+    RANGE_NONE,
+    RANGE_SATISFIABLE,
+    RANGE_UNSATISFIABLE,
+};
+
+// a single byte range of a 'size' byte file: [*first, *last].
+// RANGE_NONE if there is no range or the header is not understood,
+// in which case the whole file is sent, including multiple ranges.
+RangeResult parseRange(
+    String::CPtr range,
+    Size size,
+    Size* first,
+    Size* last);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_STATIC_FILE_H_
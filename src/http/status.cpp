@@ -1,9 +1,12 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <stdio.h>
 #include <libj/symbol.h>
 
 #include "libnode/http/status.h"
 
+#include "./status_line.h"
+
 namespace libj {
 namespace node {
 namespace http {
@@ -43,6 +46,7 @@ namespace http {
     GEN(UNSUPPORTED_MEDIA_TYPE, "Unsupported Media Type") \
     GEN(REQUESTED_RANGE_NOT_SATISFIABLE, "Requested Range Not Satisfiable") \
     GEN(EXPECTATION_FAILED, "Expectation Failed") \
+    GEN(REQUEST_HEADER_FIELDS_TOO_LARGE, "Request Header Fields Too Large") \
     GEN(INTERNAL_SERVER_ERROR, "Internal Server Error") \
     GEN(NOT_IMPLEMENTED, "Not Implemented") \
     GEN(BAD_GATEWAY, "Bad Gateway") \
@@ -94,6 +98,47 @@ Status::CPtr Status::create(Int code, String::CPtr msg) {
     return StatusImpl::create(code, msg);
 }
 
+#define LIBNODE_HTTP_STATUS_LINE_GEN(NAME, MESSAGE) \
+    { Status::NAME, MESSAGE },
+
+struct StatusLineEntry {
+    Int code;
+    const char* message;
+};
+
+static const StatusLineEntry statusLineEntries[] = {
+    LIBNODE_HTTP_STATUS_MSG_MAP(LIBNODE_HTTP_STATUS_LINE_GEN)
+};
+
+static const Int kMinStatus = 100;
+static const Int kMaxStatus = 599;
+
+static const std::string* createStatusLines() {
+    std::string* lines = new std::string[kMaxStatus - kMinStatus + 1];
+    Size num = sizeof(statusLineEntries) / sizeof(StatusLineEntry);
+    for (Size i = 0; i < num; i++) {
+        const StatusLineEntry& entry = statusLineEntries[i];
+        char buf[64];
+        int len = snprintf(
+            buf,
+            sizeof(buf),
+            "HTTP/1.1 %d %s\r\n",
+            entry.code,
+            entry.message);
+        lines[entry.code - kMinStatus].assign(buf, len);
+    }
+    return lines;
+}
+
+static const std::string* const statusLines = createStatusLines();
+
+const std::string* statusLine(Int code) {
+    if (code < kMinStatus || code > kMaxStatus) return NULL;
+
+    const std::string* line = &statusLines[code - kMinStatus];
+    return line->empty() ? NULL : line;
+}
+
 }  // namespace http
 }  // namespace node
 }  // namespace libj
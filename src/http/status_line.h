@@ -0,0 +1,22 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_HTTP_STATUS_LINE_H_
+#define LIBNODE_SRC_HTTP_STATUS_LINE_H_
+
+#include <libj/string.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+namespace http {
+
+// "HTTP/1.1 <code> <reason>\r\n" encoded once for each known status,
+// or NULL if 'code' is unknown
+const std::string* statusLine(Int code);
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_HTTP_STATUS_LINE_H_
@@ -12,8 +12,8 @@ LIBJ_SYMBOL_DEF(Server::EVENT_ERROR,      "error");
 LIBJ_SYMBOL_DEF(Server::EVENT_LISTENING,  "listening");
 LIBJ_SYMBOL_DEF(Server::EVENT_CONNECTION, "connection");
 
-Server::Ptr Server::create() {
-    return ServerImpl::create();
+Server::Ptr Server::create(JsObject::CPtr options) {
+    return ServerImpl::create(options);
 }
 
 }  // namespace net
@@ -16,8 +16,21 @@ class ServerImpl
     : public FlagMixin
     , LIBNODE_NET_SERVER(ServerImpl)
  public:
-    static Ptr create() {
-        return Ptr(new ServerImpl());
+    static Ptr create(JsObject::CPtr options = JsObject::null()) {
+        LIBJ_STATIC_SYMBOL_DEF(symAllowHalfOpen, "allowHalfOpen");
+        LIBJ_STATIC_SYMBOL_DEF(symAcceptBatch,   "acceptBatch");
+
+        ServerImpl* srv = new ServerImpl();
+        if (options) {
+            Boolean allowHalfOpen = false;
+            to<Boolean>(options->get(symAllowHalfOpen), &allowHalfOpen);
+            if (allowHalfOpen) srv->setFlag(ALLOW_HALF_OPEN);
+
+            Int acceptBatch = 0;
+            to<Int>(options->get(symAcceptBatch), &acceptBatch);
+            if (acceptBatch > 1) srv->acceptBatch_ = acceptBatch;
+        }
+        return Ptr(srv);
     }
 
     Value address() {
@@ -40,6 +53,63 @@ class ServerImpl
         return listen(host, port, 4, backlog);
     }
 
+    Boolean listen(
+        String::CPtr path,
+        JsFunction::Ptr callback = JsFunction::null()) {
+        if (!path) return false;
+
+        if (callback) once(EVENT_LISTENING, callback);
+        return listen(path, -1, -1, 511);
+    }
+
+    Boolean listen(
+        JsObject::CPtr options,
+        JsFunction::Ptr callback = JsFunction::null()) {
+        LIBJ_STATIC_SYMBOL_DEF(symPath,        "path");
+        LIBJ_STATIC_SYMBOL_DEF(symMode,        "mode");
+        LIBJ_STATIC_SYMBOL_DEF(symRemoveStale, "removeStale");
+        LIBJ_STATIC_SYMBOL_DEF(symPort,        "port");
+        LIBJ_STATIC_SYMBOL_DEF(symHost,        "host");
+        LIBJ_STATIC_SYMBOL_DEF(symBacklog,     "backlog");
+        LIBJ_STATIC_SYMBOL_DEF(symQuickAck,    "quickAck");
+
+        if (!options) return false;
+
+        Int backlog = 511;
+        to<Int>(options->get(symBacklog), &backlog);
+
+        String::CPtr path = options->getCPtr<String>(symPath);
+        if (path) {
+            Boolean removeStale = true;
+            to<Boolean>(options->get(symRemoveStale), &removeStale);
+            Int mode = -1;
+            to<Int>(options->get(symMode), &mode);
+
+            if (callback) once(EVENT_LISTENING, callback);
+            return listen(path, -1, -1, backlog, -1,
+                          JsObject::null(), removeStale, mode);
+        }
+
+        Int port = -1;
+        to<Int>(options->get(symPort), &port);
+        if (port < 0) return false;
+
+        String::CPtr host = options->getCPtr<String>(symHost);
+        if (!host) host = IN_ADDR_ANY;
+        Int addressType = isIP(host) == 6 ? 6 : 4;
+
+        Boolean quickAck = false;
+        to<Boolean>(options->get(symQuickAck), &quickAck);
+        if (quickAck) {
+            setFlag(QUICK_ACK);
+        } else {
+            unsetFlag(QUICK_ACK);
+        }
+
+        if (callback) once(EVENT_LISTENING, callback);
+        return listen(host, port, addressType, backlog, -1, options);
+    }
+
     Boolean close(
         JsFunction::Ptr callback = JsFunction::null()) {
         if (!handle_) return false;
@@ -48,10 +118,31 @@ class ServerImpl
 
         handle_->close();
         handle_ = NULL;
+        pipeName_ = String::null();
         emitCloseIfDrained();
         return true;
     }
 
+    JsObject::Ptr acceptStats() {
+        LIBJ_STATIC_SYMBOL_DEF(symAcceptBatch,          "acceptBatch");
+        LIBJ_STATIC_SYMBOL_DEF(symAccepts,              "accepts");
+        LIBJ_STATIC_SYMBOL_DEF(symWakeups,              "wakeups");
+        LIBJ_STATIC_SYMBOL_DEF(symLastAcceptsPerWakeup, "lastAcceptsPerWakeup");
+        LIBJ_STATIC_SYMBOL_DEF(symMaxAcceptsPerWakeup,  "maxAcceptsPerWakeup");
+
+        JsObject::Ptr stats = JsObject::create();
+        stats->put(symAcceptBatch, acceptBatch_);
+        if (handle_) {
+            stats->put(symAccepts, handle_->accepts());
+            stats->put(symWakeups, handle_->acceptWakeups());
+            stats->put(symLastAcceptsPerWakeup,
+                       handle_->lastAcceptsPerWakeup());
+            stats->put(symMaxAcceptsPerWakeup,
+                       handle_->maxAcceptsPerWakeup());
+        }
+        return stats;
+    }
+
     void ref() {
         if (handle_) handle_->ref();
     }
@@ -66,25 +157,28 @@ class ServerImpl
         Int port = -1,
         Int addressType = -1,
         int fd = -1) {
-        uv::Stream* handle;
         if (fd >= 0) {
             uv::Pipe* pipe = new uv::Pipe();
             pipe->open(fd);
             return pipe;
-        } else if (port == -1 && addressType == -1) {
-            handle = new uv::Pipe();
-        } else {
-            handle = new uv::Tcp();
         }
 
+        uv::Stream* handle;
         Int r = 0;
-        if (address || port) {
-            uv::Tcp* tcp = static_cast<uv::Tcp*>(handle);
-            if (addressType == 6) {
-                r = tcp->bind6(address, port);
-            } else {
-                r = tcp->bind(address, port);
+        if (port == -1 && addressType == -1) {
+            uv::Pipe* pipe = new uv::Pipe();
+            r = pipe->bind(address);
+            handle = pipe;
+        } else {
+            uv::Tcp* tcp = new uv::Tcp();
+            if (address || port) {
+                if (addressType == 6) {
+                    r = tcp->bind6(address, port);
+                } else {
+                    r = tcp->bind(address, port);
+                }
             }
+            handle = tcp;
         }
 
         if (r) {
@@ -100,18 +194,50 @@ class ServerImpl
         Int port,
         Int addressType,
         Int backlog = 0,
-        int fd = -1) {
+        int fd = -1,
+        JsObject::CPtr tcpOptions = JsObject::null(),
+        Boolean removeStale = true,
+        Int mode = -1) {
+        Boolean pipe = port == -1 && addressType == -1 && fd < 0;
         if (!handle_) {
+            if (pipe && removeStale && uv::Pipe::removeStale(address)) {
+                EmitError::Ptr emitError(new EmitError(this));
+                process::nextTick(emitError);
+                return false;
+            }
+
             handle_ = createServerHandle(address, port, addressType, fd);
             if (!handle_) {
                 EmitError::Ptr emitError(new EmitError(this));
                 process::nextTick(emitError);
                 return false;
             }
+
+            if (pipe && mode >= 0 &&
+                static_cast<uv::Pipe*>(handle_)->setMode(mode)) {
+                handle_->close();
+                handle_ = NULL;
+                EmitError::Ptr emitError(new EmitError(this));
+                process::nextTick(emitError);
+                return false;
+            }
+
+            // the socket exists after bind, so set them before listen
+            if (tcpOptions &&
+                handle_->type() == UV_TCP &&
+                !SocketImpl::setTcpOptions(
+                    static_cast<uv::Tcp*>(handle_), tcpOptions, true)) {
+                handle_->close();
+                handle_ = NULL;
+                EmitError::Ptr emitError(new EmitError(this));
+                process::nextTick(emitError);
+                return false;
+            }
         }
 
         OnConnection::Ptr onConnection(new OnConnection(this));
         handle_->setOnConnection(onConnection);
+        handle_->setAcceptBatch(acceptBatch_);
 
         Int r = handle_->listen(backlog ? backlog : 511);
         if (r) {
@@ -121,6 +247,7 @@ class ServerImpl
             process::nextTick(emitError);
             return false;
         } else {
+            if (pipe) pipeName_ = address;
             // connectionKey = addressType + ':' + address + ':' + port;
             EmitListening::Ptr emitListening(new EmitListening(this));
             process::nextTick(emitListening);
@@ -145,20 +272,35 @@ class ServerImpl
 
         Value operator()(JsArray::Ptr args) {
             Value client = args->get(0);
-            uv::Stream* clientHandle = NULL;
-            uv::Pipe* pipe;
-            uv::Tcp* tcp;
-            if (to<uv::Pipe*>(client, &pipe)) {
-                clientHandle = pipe;
-            } else if (to<uv::Tcp*>(client, &tcp)) {
-                clientHandle = tcp;
+            JsArray::Ptr clients = toPtr<JsArray>(client);
+            if (clients) {
+                // a batch of connections accepted in one loop iteration
+                Size len = clients->length();
+                self_->connections_ += len;
+                for (Size i = 0; i < len; i++) {
+                    uv::Stream* clientHandle = NULL;
+                    to<uv::Stream*>(clients->get(i), &clientHandle);
+                    assert(clientHandle);
+                    setup(clientHandle);
+                }
+                return Status::OK;
             }
+
+            uv::Stream* clientHandle = NULL;
+            to<uv::Stream*>(client, &clientHandle);
             if (!clientHandle) {
                 EmitError::Ptr emitError(new EmitError(self_));
                 process::nextTick(emitError);
                 return Error::ILLEGAL_STATE;
             }
 
+            self_->connections_++;
+            setup(clientHandle);
+            return Status::OK;
+        }
+
+     private:
+        void setup(uv::Stream* clientHandle) {
             #if 0
             if (self_->maxConnections &&
                 self_->connections >= self_->maxConnections) {
@@ -173,14 +315,17 @@ class ServerImpl
             socket->setFlag(SocketImpl::READABLE);
             socket->setFlag(SocketImpl::WRITABLE);
 
+            if (self_->hasFlag(QUICK_ACK) &&
+                clientHandle->type() == UV_TCP) {
+                static_cast<uv::Tcp*>(clientHandle)->setQuickAck(true);
+            }
+
             clientHandle->readStart();
 
-            self_->connections_++;
             // socket.server = self;
 
             self_->emit(EVENT_CONNECTION, socket);
             socket->emit(SocketImpl::EVENT_CONNECT);
-            return Status::OK;
         }
     };
 
@@ -226,17 +371,20 @@ class ServerImpl
  public:
     enum Flag {
         ALLOW_HALF_OPEN = 1 << 0,
+        QUICK_ACK       = 1 << 1,
     };
 
  private:
     uv::Stream* handle_;
     Size connections_;
+    Size acceptBatch_;
     String::CPtr pipeName_;
     events::EventEmitter::Ptr ee_;
 
     ServerImpl()
         : handle_(NULL)
         , connections_(0)
+        , acceptBatch_(1)
         , pipeName_(String::null())
         , ee_(events::EventEmitter::create()) {}
 
@@ -12,6 +12,7 @@
 #include "libnode/uv/error.h"
 
 #include "../flag.h"
+#include "../stream/pipe.h"
 #include "../uv/pipe.h"
 #include "../uv/tcp.h"
 
@@ -163,6 +164,12 @@ class SocketImpl
         return handle_ && !hasFlag(CONNECTING) && !handle_->readStart();
     }
 
+    Stream::Ptr pipe(
+        Stream::Ptr dest,
+        JsObject::CPtr options = JsObject::null()) {
+        return stream::pipe(this, dest, options);
+    }
+
     void ref() {
         if (handle_) handle_->ref();
     }
@@ -204,6 +211,13 @@ class SocketImpl
         }
         if (!buf) return false;
 
+        if (sendQueue_) {
+            // keep the order with the files being sent
+            sendQueue_->push(buf);
+            sendCbQueue_->push(cb);
+            return false;
+        }
+
         if (hasFlag(CONNECTING)) {
             connectQueueSize_ += buf->length();
             if (!connectBufQueue_) {
@@ -216,9 +230,80 @@ class SocketImpl
             return false;
         }
 
+        if (corked_) {
+            if (!corkBufQueue_) {
+                corkBufQueue_ = JsArray::create();
+                corkCbQueue_ = JsArray::create();
+            }
+            corkBufQueue_->push(buf);
+            corkCbQueue_->push(cb);
+            corkedSize_ += buf->length();
+
+            // 'drain' follows the write of the corked buffers
+            return bufferSize() < kHighWaterMark;
+        }
+
         return writeBuffer(buf, cb);
     }
 
+    // hold the writes until uncork() is called as many times,
+    // and then send them in one vectored write
+    void cork() {
+        corked_++;
+    }
+
+    void uncork() {
+        if (!corked_) return;
+
+        if (!--corked_) flushCorked();
+    }
+
+    // the bytes accepted by write() and not yet sent
+    Size bufferSize() const {
+        Size size = connectQueueSize_ + corkedSize_;
+        if (handle_) size += handle_->writeQueueSize();
+        return size;
+    }
+
+    // send a region of the file 'fd' with sendfile(2).
+    // the file must stay open until the callback is called.
+    Boolean sendFile(
+        int fd,
+        Size offset,
+        Size length,
+        JsFunction::Ptr cb = JsFunction::null()) {
+        if (fd < 0 || !hasFlag(WRITABLE) || hasFlag(CONNECTING)) {
+            return false;
+        }
+
+        if (!length) {
+            if (cb) process::nextTick(cb);
+            return true;
+        }
+
+        // the file follows the data written before
+        flushCorked();
+
+        if (!sendQueue_) {
+            sendQueue_ = JsArray::create();
+            sendCbQueue_ = JsArray::create();
+        }
+        JsArray::Ptr file = JsArray::create();
+        file->add(fd);
+        file->add(offset);
+        file->add(length);
+        sendQueue_->push(file);
+        sendCbQueue_->push(cb);
+
+        processSendQueue();
+
+        // the file already shifted off the queue is still being sent,
+        // so wait for 'drain' as after write()
+        return !hasFlag(SENDING_FILE) &&
+            !pendingWriteReqs_ &&
+            (!sendQueue_ || sendQueue_->isEmpty());
+    }
+
     Boolean end(
         const Value& data = UNDEFINED,
         Buffer::Encoding enc = Buffer::NONE) {
@@ -236,6 +321,9 @@ class SocketImpl
 
         if (!data.isUndefined()) write(data, enc);
 
+        corked_ = 0;
+        flushCorked();
+
         if (!hasFlag(READABLE)) {
             return destroySoon();
         } else {
@@ -262,9 +350,16 @@ class SocketImpl
     Boolean destroySoon() {
         if (hasFlag(DESTROYED)) return false;
 
+        corked_ = 0;
+        flushCorked();
+
         unsetFlag(WRITABLE);
         setFlag(DESTROY_SOON);
-        return destroy();
+        if (pendingWriteReqs_ || sendQueue_) {
+            return true;
+        } else {
+            return destroy();
+        }
     }
 
     Boolean readable() const {
@@ -296,6 +391,10 @@ class SocketImpl
         }
     }
 
+    JsFunction::Ptr onData() const {
+        return onData_;
+    }
+
     void setOnData(JsFunction::Ptr onData) {
         if (onData_)
             removeListener(EVENT_DATA, onData_);
@@ -370,13 +469,61 @@ class SocketImpl
         if (path) {
             return connect(path, cb);
         } else if (port >= 0) {
-            connect(port, host, localAddress, String::null(), cb);
+            connect(port, host, localAddress, String::null(), cb, options);
             return true;
         } else {
             return false;
         }
     }
 
+    // sendBufferSize, receiveBufferSize, deferAccept, fastOpen,
+    // quickAck and notSentLowat (the latter four are Linux only)
+    static Boolean setTcpOptions(
+        uv::Tcp* tcp,
+        JsObject::CPtr options,
+        Boolean listening) {
+        LIBJ_STATIC_SYMBOL_DEF(symSendBufferSize,    "sendBufferSize");
+        LIBJ_STATIC_SYMBOL_DEF(symReceiveBufferSize, "receiveBufferSize");
+        LIBJ_STATIC_SYMBOL_DEF(symDeferAccept,       "deferAccept");
+        LIBJ_STATIC_SYMBOL_DEF(symFastOpen,          "fastOpen");
+        LIBJ_STATIC_SYMBOL_DEF(symQuickAck,          "quickAck");
+        LIBJ_STATIC_SYMBOL_DEF(symNotSentLowat,      "notSentLowat");
+
+        if (!tcp || !options) return true;
+
+        Int r = 0;
+        Int i;
+        Boolean b;
+        if (to<Int>(options->get(symSendBufferSize), &i)) {
+            r = tcp->setSendBufferSize(i);
+        }
+        if (!r && to<Int>(options->get(symReceiveBufferSize), &i)) {
+            r = tcp->setReceiveBufferSize(i);
+        }
+        if (!r && to<Int>(options->get(symNotSentLowat), &i)) {
+            r = tcp->setNotSentLowat(i);
+        }
+        if (listening) {
+            // fastOpen is the length of the pending TFO request queue
+            if (!r && to<Int>(options->get(symFastOpen), &i)) {
+                r = tcp->setFastOpen(i);
+            }
+            if (!r && to<Int>(options->get(symDeferAccept), &i)) {
+                r = tcp->setDeferAccept(i);
+            }
+            // quickAck is not inherited by accepted sockets,
+            // so the server applies it to each connection
+        } else {
+            if (!r && to<Boolean>(options->get(symFastOpen), &b)) {
+                r = tcp->setFastOpenConnect(b);
+            }
+            if (!r && to<Boolean>(options->get(symQuickAck), &b)) {
+                r = tcp->setQuickAck(b);
+            }
+        }
+        return !r;
+    }
+
  private:
     static void initSocketHandle(SocketImpl* self) {
         self->flags_ = 0;
@@ -408,15 +555,36 @@ class SocketImpl
         }
     }
 
+    static Boolean needsSocketBeforeConnect(JsObject::CPtr options) {
+        LIBJ_STATIC_SYMBOL_DEF(symSendBufferSize,    "sendBufferSize");
+        LIBJ_STATIC_SYMBOL_DEF(symReceiveBufferSize, "receiveBufferSize");
+        LIBJ_STATIC_SYMBOL_DEF(symFastOpen,          "fastOpen");
+
+        return options && (
+            options->containsKey(symSendBufferSize) ||
+            options->containsKey(symReceiveBufferSize) ||
+            options->containsKey(symFastOpen));
+    }
+
     static void connect(
         SocketImpl* self,
         uv::Tcp* handle,
         String::CPtr address,
         Int port,
         Int addressType,
-        String::CPtr localAddress) {
+        String::CPtr localAddress,
+        JsObject::CPtr tcpOptions = JsObject::null()) {
+        LIBJ_STATIC_SYMBOL_DEF(symAny4, "0.0.0.0");
+        LIBJ_STATIC_SYMBOL_DEF(symAny6, "::");
+
         assert(self->hasFlag(CONNECTING));
 
+        // libuv creates the socket lazily, but the buffer sizes and
+        // TCP_FASTOPEN_CONNECT have to be set before connect(2)
+        if (!localAddress && needsSocketBeforeConnect(tcpOptions)) {
+            localAddress = addressType == 6 ? symAny6 : symAny4;
+        }
+
         if (localAddress) {
             Int r;
             if (addressType == 6) {
@@ -431,6 +599,15 @@ class SocketImpl
             }
         }
 
+        Boolean optionsSet = false;
+        if (tcpOptions && handle->fd() >= 0) {
+            if (!setTcpOptions(handle, tcpOptions, false)) {
+                self->destroy(uv::Error::last());
+                return;
+            }
+            optionsSet = true;
+        }
+
         uv::Connect* creq;
         if (addressType == 6) {
             creq = handle->connect6(address, port);
@@ -438,10 +615,17 @@ class SocketImpl
             creq = handle->connect(address, port);
         }
 
-        if (creq) {
-            AfterConnect::Ptr afterConnect(new AfterConnect(self, creq));
-            creq->onComplete = afterConnect;
-        } else {
+        if (!creq) {
+            self->destroy(uv::Error::last());
+            return;
+        }
+
+        AfterConnect::Ptr afterConnect(new AfterConnect(self, creq));
+        creq->onComplete = afterConnect;
+
+        // the connect in progress completes on the destroyed socket
+        if (tcpOptions && !optionsSet &&
+            !setTcpOptions(handle, tcpOptions, false)) {
             self->destroy(uv::Error::last());
         }
     }
@@ -451,7 +635,8 @@ class SocketImpl
         String::CPtr host,
         String::CPtr localAddress,
         String::CPtr path,
-        JsFunction::Ptr cb) {
+        JsFunction::Ptr cb,
+        JsObject::CPtr tcpOptions = JsObject::null()) {
         LIBJ_STATIC_SYMBOL_DEF(symLocalhost4, "127.0.0.1");
 
         Boolean pipe = !!path;
@@ -475,13 +660,17 @@ class SocketImpl
         } else {
             uv::Tcp* tcp = reinterpret_cast<uv::Tcp*>(handle_);
             if (!host) {
-                connect(this, tcp, symLocalhost4, port, 4, String::null());
+                connect(
+                    this, tcp, symLocalhost4, port, 4,
+                    String::null(), tcpOptions);
             } else {
                 // TODO(plenluno): dns lookup
 
                 Int addressType = net::isIP(host);
                 if (addressType) {
-                    connect(this, tcp, host, port, addressType, localAddress);
+                    connect(
+                        this, tcp, host, port, addressType,
+                        localAddress, tcpOptions);
                 } else {
                     libj::Error::CPtr err =
                         libj::Error::create(libj::Error::ILLEGAL_ARGUMENT);
@@ -492,6 +681,80 @@ class SocketImpl
         }
     }
 
+    void processSendQueue() {
+        while (sendQueue_ &&
+               !hasFlag(SENDING_FILE) &&
+               !hasFlag(DESTROYED)) {
+            if (sendQueue_->isEmpty()) {
+                sendQueue_ = JsArray::null();
+                sendCbQueue_ = JsArray::null();
+                break;
+            }
+
+            JsArray::CPtr file = sendQueue_->getCPtr<JsArray>(0);
+            if (file && pendingWriteReqs_) {
+                // sendfile(2) bypasses the write queue of libuv
+                break;
+            }
+
+            Value data = sendQueue_->shift();
+            JsFunction::Ptr cb = toPtr<JsFunction>(sendCbQueue_->shift());
+            if (file) {
+                int fd = -1;
+                Size offset = 0;
+                Size length = 0;
+                to<int>(file->get(0), &fd);
+                to<Size>(file->get(1), &offset);
+                to<Size>(file->get(2), &length);
+                startSendFile(fd, offset, length, cb);
+            } else {
+                writeBuffer(toCPtr<Buffer>(data), cb);
+            }
+        }
+    }
+
+    void startSendFile(
+        int fd,
+        Size offset,
+        Size length,
+        JsFunction::Ptr cb) {
+        active();
+
+        if (!handle_) {
+            destroy(libj::Error::create(Error::ILLEGAL_STATE), cb);
+            return;
+        }
+
+        uv::SendFile* req = handle_->sendFile(fd, offset, length);
+        if (!req) {
+            destroy(uv::Error::last(), cb);
+            return;
+        }
+
+        AfterSendFile::Ptr afterSendFile(new AfterSendFile(this, req));
+        req->onComplete = afterSendFile;
+        req->cb = cb;
+
+        setFlag(SENDING_FILE);
+        pendingWriteReqs_++;
+        bytesDispatched_ += length;
+    }
+
+    void afterWriteReq(JsFunction::Ptr cb) {
+        active();
+        pendingWriteReqs_--;
+        if (sendQueue_) processSendQueue();
+        if (pendingWriteReqs_ == 0) {
+            emit(EVENT_DRAIN);
+        }
+
+        if (cb) (*cb)();
+
+        if (pendingWriteReqs_ == 0 && hasFlag(DESTROY_SOON)) {
+            destroy();
+        }
+    }
+
     void connectQueueCleanUp() {
         unsetFlag(CONNECTING);
         connectQueueSize_ = 0;
@@ -514,6 +777,12 @@ class SocketImpl
         }
 
         connectQueueCleanUp();
+        sendQueue_ = JsArray::null();
+        sendCbQueue_ = JsArray::null();
+        corked_ = 0;
+        corkBufQueue_ = JsArray::null();
+        corkCbQueue_ = JsArray::null();
+        corkedSize_ = 0;
         unsetFlag(READABLE);
         unsetFlag(WRITABLE);
         finishTimer();
@@ -543,6 +812,59 @@ class SocketImpl
         #undef FIRE_ERROR_CALLBACKS
     }
 
+    void flushCorked() {
+        if (!corkBufQueue_) return;
+
+        JsArray::Ptr bufs = corkBufQueue_;
+        JsArray::Ptr cbs = corkCbQueue_;
+        corkBufQueue_ = JsArray::null();
+        corkCbQueue_ = JsArray::null();
+        corkedSize_ = 0;
+
+        JsFunction::Ptr cb = JsFunction::null();
+        Size len = cbs->length();
+        for (Size i = 0; i < len; i++) {
+            JsFunction::Ptr f = cbs->getPtr<JsFunction>(i);
+            if (!f) continue;
+
+            if (cb) {
+                cb = CallEach::create(cbs);
+                break;
+            }
+            cb = f;
+        }
+
+        if (bufs->length() == 1) {
+            writeBuffer(bufs->getCPtr<Buffer>(0), cb);
+        } else {
+            writeBuffers(bufs, cb);
+        }
+    }
+
+    Boolean writeBuffers(JsArray::CPtr bufs, JsFunction::Ptr cb) {
+        active();
+
+        if (!handle_) {
+            destroy(libj::Error::create(Error::ILLEGAL_STATE), cb);
+            return false;
+        }
+
+        uv::Write* req = handle_->writeBuffers(bufs);
+
+        if (!req) {
+            destroy(uv::Error::last(), cb);
+            return false;
+        }
+
+        AfterWrite::Ptr afterWrite(new AfterWrite(this, req));
+        req->onComplete = afterWrite;
+        req->cb = cb;
+
+        pendingWriteReqs_++;
+        bytesDispatched_ += req->bytes;
+        return true;
+    }
+
     Boolean writeBuffer(Buffer::CPtr buf, JsFunction::Ptr cb) {
         active();
 
@@ -647,6 +969,28 @@ class SocketImpl
         }
     };
 
+    // the callbacks of the writes sent together by flushCorked
+    class CallEach : LIBJ_JS_FUNCTION(CallEach)
+     public:
+        static Ptr create(JsArray::Ptr cbs) {
+            return Ptr(new CallEach(cbs));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            Size len = cbs_->length();
+            for (Size i = 0; i < len; i++) {
+                JsFunction::Ptr cb = cbs_->getPtr<JsFunction>(i);
+                if (cb) (*cb)(args);
+            }
+            return Status::OK;
+        }
+
+     private:
+        JsArray::Ptr cbs_;
+
+        CallEach(JsArray::Ptr cbs) : cbs_(cbs) {}
+    };
+
     class AfterWrite : LIBJ_JS_FUNCTION(AfterWrite)
      private:
         SocketImpl* self_;
@@ -672,18 +1016,39 @@ class SocketImpl
                 return err->code();
             }
 
-            self_->active();
-            self_->pendingWriteReqs_--;
-            if (self_->pendingWriteReqs_ == 0) {
-                self_->emit(EVENT_DRAIN);
+            self_->afterWriteReq(req_->cb);
+            return Status::OK;
+        }
+    };
+
+    class AfterSendFile : LIBJ_JS_FUNCTION(AfterSendFile)
+     private:
+        SocketImpl* self_;
+        uv::SendFile* req_;
+
+     public:
+        AfterSendFile(
+            SocketImpl* sock,
+            uv::SendFile* req)
+            : self_(sock)
+            , req_(req) {}
+
+        Value operator()(JsArray::Ptr args) {
+            if (self_->hasFlag(DESTROYED)) {
+                return libj::Error::ILLEGAL_STATE;
             }
 
-            if (req_->cb) (*req_->cb)();
+            self_->unsetFlag(SENDING_FILE);
 
-            if (self_->pendingWriteReqs_ == 0 &&
-                self_->hasFlag(DESTROY_SOON)) {
-                self_->destroy();
+            int status;
+            to<int>(args->get(0), &status);
+            if (status) {
+                uv::Error::CPtr err = uv::Error::last();
+                self_->destroy(err, req_->cb);
+                return err->code();
             }
+
+            self_->afterWriteReq(req_->cb);
             return Status::OK;
         }
     };
@@ -856,9 +1221,13 @@ class SocketImpl
         SHUTDOWN_QUEUED = 1 << 8,
         ERROR_EMITTED   = 1 << 9,
         ALLOW_HALF_OPEN = 1 << 10,
+        SENDING_FILE    = 1 << 11,
     };
 
  private:
+    // write() asks for a 'drain' once this many bytes are buffered
+    static const Size kHighWaterMark = 16 * 1024;
+
     uv::Stream* handle_;
     Value timer_;
     Int timeout_;
@@ -866,6 +1235,12 @@ class SocketImpl
     Size connectQueueSize_;
     JsArray::Ptr connectBufQueue_;
     JsArray::Ptr connectCbQueue_;
+    JsArray::Ptr sendQueue_;
+    JsArray::Ptr sendCbQueue_;
+    Size corked_;
+    JsArray::Ptr corkBufQueue_;
+    JsArray::Ptr corkCbQueue_;
+    Size corkedSize_;
     Size bytesRead_;
     Size bytesDispatched_;
     StringDecoder::Ptr decoder_;
@@ -883,6 +1258,12 @@ class SocketImpl
         , connectQueueSize_(0)
         , connectBufQueue_(JsArray::null())
         , connectCbQueue_(JsArray::null())
+        , sendQueue_(JsArray::null())
+        , sendCbQueue_(JsArray::null())
+        , corked_(0)
+        , corkBufQueue_(JsArray::null())
+        , corkCbQueue_(JsArray::null())
+        , corkedSize_(0)
         , bytesRead_(0)
         , bytesDispatched_(0)
         , decoder_(StringDecoder::null())
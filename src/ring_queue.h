@@ -0,0 +1,81 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_RING_QUEUE_H_
+#define LIBNODE_SRC_RING_QUEUE_H_
+
+#include <assert.h>
+
+#include <vector>
+
+namespace libj {
+namespace node {
+
+// a FIFO queue on a circular buffer, which doubles when it is full.
+// push and shift neither move the elements nor allocate
+// once the queue has grown to its working size.
+template<typename T>
+class RingQueue {
+ public:
+    RingQueue() : head_(0), length_(0) {}
+
+    Size length() const {
+        return length_;
+    }
+
+    Boolean isEmpty() const {
+        return !length_;
+    }
+
+    void push(const T& t) {
+        if (length_ == buf_.size()) grow();
+        buf_[index(length_)] = t;
+        length_++;
+    }
+
+    T shift() {
+        assert(length_);
+        T t = buf_[head_];
+        buf_[head_] = T();
+        head_ = index(1);
+        length_--;
+        return t;
+    }
+
+    T& front() {
+        assert(length_);
+        return buf_[head_];
+    }
+
+    T& back() {
+        assert(length_);
+        return buf_[index(length_ - 1)];
+    }
+
+    void clear() {
+        while (length_) shift();
+    }
+
+ private:
+    Size index(Size i) const {
+        return (head_ + i) & (buf_.size() - 1);
+    }
+
+    void grow() {
+        std::vector<T> buf(buf_.empty() ? 8 : buf_.size() * 2);
+        for (Size i = 0; i < length_; i++) {
+            buf[i] = buf_[index(i)];
+        }
+        buf_.swap(buf);
+        head_ = 0;
+    }
+
+ private:
+    std::vector<T> buf_;
+    Size head_;
+    Size length_;
+};
+
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_RING_QUEUE_H_
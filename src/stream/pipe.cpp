@@ -0,0 +1,253 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <assert.h>
+
+#include "./pipe.h"
+
+namespace libj {
+namespace node {
+namespace stream {
+
+class Pipe : LIBJ_JS_FUNCTION(Pipe)
+ public:
+    static Ptr create(
+        ReadableStream* readable,
+        DuplexStream* duplex,
+        Stream::Ptr dest,
+        JsObject::CPtr options) {
+        LIBJ_STATIC_SYMBOL_DEF(symEnd, "end");
+
+        Pipe* pipe = new Pipe(readable, duplex, dest);
+        if (!pipe->writable_ && !pipe->duplexDest_) {
+            delete pipe;
+            return null();
+        }
+
+        if (options) {
+            to<Boolean>(options->get(symEnd), &pipe->end_);
+        }
+        return Ptr(pipe);
+    }
+
+    // cleanup
+    Value operator()(JsArray::Ptr args) {
+        cleanup();
+        return Status::OK;
+    }
+
+    void start(Ptr self) {
+        onData_ = Listener::create(self, Listener::DATA);
+        onDrain_ = Listener::create(self, Listener::DRAIN);
+        onEnd_ = Listener::create(self, Listener::END);
+        onClose_ = Listener::create(self, Listener::CLOSE);
+        cleanup_ = self;
+
+        src_->on(ReadableStream::EVENT_DATA, onData_);
+        dest_->on(WritableStream::EVENT_DRAIN, onDrain_);
+
+        if (end_) {
+            src_->on(ReadableStream::EVENT_END, onEnd_);
+            src_->on(Stream::EVENT_CLOSE, onClose_);
+        }
+
+        src_->on(ReadableStream::EVENT_END, cleanup_);
+        src_->on(Stream::EVENT_CLOSE, cleanup_);
+        src_->on(Stream::EVENT_ERROR, cleanup_);
+        dest_->on(Stream::EVENT_CLOSE, cleanup_);
+        dest_->on(Stream::EVENT_ERROR, cleanup_);
+
+        if (readable_) {
+            dest_->emit(WritableStream::EVENT_PIPE, readable_);
+        } else {
+            dest_->emit(WritableStream::EVENT_PIPE, duplex_);
+        }
+    }
+
+ private:
+    class Listener : LIBJ_JS_FUNCTION(Listener)
+     public:
+        enum Kind {
+            DATA,
+            DRAIN,
+            END,
+            CLOSE,
+        };
+
+        static Ptr create(Pipe::Ptr pipe, Kind kind) {
+            return Ptr(new Listener(pipe, kind));
+        }
+
+        Value operator()(JsArray::Ptr args) {
+            switch (kind_) {
+            case DATA:
+                pipe_->onData(args->get(0));
+                break;
+            case DRAIN:
+                pipe_->onDrain();
+                break;
+            case END:
+                pipe_->onEnd();
+                break;
+            case CLOSE:
+                pipe_->onClose();
+                break;
+            default:
+                assert(false);
+            }
+            return Status::OK;
+        }
+
+     private:
+        Pipe::Ptr pipe_;
+        Kind kind_;
+
+        Listener(Pipe::Ptr pipe, Kind kind)
+            : pipe_(pipe)
+            , kind_(kind) {}
+    };
+
+    void onData(const Value& chunk) {
+        if (!writable()) return;
+
+        // a false return means 'dest' buffered the chunk
+        if (!write(chunk)) pause();
+    }
+
+    void onDrain() {
+        resume();
+    }
+
+    void onEnd() {
+        if (ended_) return;
+        ended_ = true;
+
+        if (writable_) {
+            writable_->end();
+        } else {
+            duplexDest_->end();
+        }
+    }
+
+    void onClose() {
+        if (ended_) return;
+        ended_ = true;
+
+        dest_->destroy();
+    }
+
+    void cleanup() {
+        if (!cleanup_) return;
+
+        src_->removeListener(ReadableStream::EVENT_DATA, onData_);
+        dest_->removeListener(WritableStream::EVENT_DRAIN, onDrain_);
+        src_->removeListener(ReadableStream::EVENT_END, onEnd_);
+        src_->removeListener(Stream::EVENT_CLOSE, onClose_);
+
+        src_->removeListener(ReadableStream::EVENT_END, cleanup_);
+        src_->removeListener(Stream::EVENT_CLOSE, cleanup_);
+        src_->removeListener(Stream::EVENT_ERROR, cleanup_);
+        dest_->removeListener(Stream::EVENT_CLOSE, cleanup_);
+        dest_->removeListener(Stream::EVENT_ERROR, cleanup_);
+
+        onData_ = JsFunction::null();
+        onDrain_ = JsFunction::null();
+        onEnd_ = JsFunction::null();
+        onClose_ = JsFunction::null();
+        cleanup_ = JsFunction::null();
+    }
+
+    Boolean writable() const {
+        if (writable_) {
+            return writable_->writable();
+        } else {
+            return duplexDest_->writable();
+        }
+    }
+
+    Boolean write(const Value& chunk) {
+        if (writable_) {
+            return writable_->write(chunk);
+        } else {
+            return duplexDest_->write(chunk);
+        }
+    }
+
+    void pause() {
+        if (readable_) {
+            readable_->pause();
+        } else {
+            duplex_->pause();
+        }
+    }
+
+    void resume() {
+        if (readable_) {
+            readable_->resume();
+        } else {
+            duplex_->resume();
+        }
+    }
+
+ private:
+    ReadableStream* readable_;
+    DuplexStream* duplex_;
+    events::EventEmitter* src_;
+    Stream::Ptr dest_;
+    WritableStream::Ptr writable_;
+    DuplexStream::Ptr duplexDest_;
+    Boolean end_;
+    Boolean ended_;
+    JsFunction::Ptr onData_;
+    JsFunction::Ptr onDrain_;
+    JsFunction::Ptr onEnd_;
+    JsFunction::Ptr onClose_;
+    JsFunction::Ptr cleanup_;
+
+    Pipe(
+        ReadableStream* readable,
+        DuplexStream* duplex,
+        Stream::Ptr dest)
+        : readable_(readable)
+        , duplex_(duplex)
+        , src_(readable
+            ? static_cast<events::EventEmitter*>(readable)
+            : static_cast<events::EventEmitter*>(duplex))
+        , dest_(dest)
+        , writable_(toPtr<WritableStream>(dest))
+        , duplexDest_(toPtr<DuplexStream>(dest))
+        , end_(true)
+        , ended_(false)
+        , onData_(JsFunction::null())
+        , onDrain_(JsFunction::null())
+        , onEnd_(JsFunction::null())
+        , onClose_(JsFunction::null())
+        , cleanup_(JsFunction::null()) {}
+};
+
+Stream::Ptr pipe(
+    ReadableStream* src,
+    Stream::Ptr dest,
+    JsObject::CPtr options) {
+    assert(src);
+    Pipe::Ptr p = Pipe::create(src, NULL, dest, options);
+    if (!p) return Stream::null();
+
+    p->start(p);
+    return dest;
+}
+
+Stream::Ptr pipe(
+    DuplexStream* src,
+    Stream::Ptr dest,
+    JsObject::CPtr options) {
+    assert(src);
+    Pipe::Ptr p = Pipe::create(NULL, src, dest, options);
+    if (!p) return Stream::null();
+
+    p->start(p);
+    return dest;
+}
+
+}  // namespace stream
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,29 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_STREAM_PIPE_H_
+#define LIBNODE_SRC_STREAM_PIPE_H_
+
+#include "libnode/stream.h"
+
+namespace libj {
+namespace node {
+namespace stream {
+
+// write all the data of 'src' to 'dest' (a WritableStream or a
+// DuplexStream), pausing 'src' while 'dest' is full.
+// chunks are forwarded as they are, so Buffers are never copied.
+Stream::Ptr pipe(
+    ReadableStream* src,
+    Stream::Ptr dest,
+    JsObject::CPtr options);
+
+Stream::Ptr pipe(
+    DuplexStream* src,
+    Stream::Ptr dest,
+    JsObject::CPtr options);
+
+}  // namespace stream
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_STREAM_PIPE_H_
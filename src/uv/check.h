@@ -0,0 +1,61 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_UV_CHECK_H_
+#define LIBNODE_SRC_UV_CHECK_H_
+
+#include <libj/js_function.h>
+
+#include "./handle.h"
+
+namespace libj {
+namespace node {
+namespace uv {
+
+class Check : public Handle {
+ public:
+    uv_check_t* uvCheck() { return &check_; }
+
+    Check()
+        : Handle(reinterpret_cast<uv_handle_t*>(&check_))
+        , onCheck_(JsFunction::null()) {
+        Int r = uv_check_init(uv_default_loop(), &check_);
+        assert(r == 0);
+        check_.data = this;
+    }
+
+    Int start() {
+        Int r = uv_check_start(&check_, onCheck);
+        if (r) setLastError();
+        return r;
+    }
+
+    Int stop() {
+        Int r = uv_check_stop(&check_);
+        if (r) setLastError();
+        return r;
+    }
+
+    Boolean isActive() const {
+        return !!uv_is_active(reinterpret_cast<const uv_handle_t*>(&check_));
+    }
+
+    void setOnCheck(JsFunction::Ptr callback) {
+        onCheck_ = callback;
+    }
+
+ private:
+    static void onCheck(uv_check_t* handle, int status) {
+        Check* self = static_cast<Check*>(handle->data);
+        if (self->onCheck_) self->onCheck_->call(status);
+    }
+
+ private:
+    uv_check_t check_;
+    JsFunction::Ptr onCheck_;
+};
+
+}  // namespace uv
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_UV_CHECK_H_
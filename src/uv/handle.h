@@ -4,6 +4,7 @@
 #define LIBNODE_SRC_UV_HANDLE_H_
 
 #include <assert.h>
+#include <errno.h>
 #include <uv.h>
 
 #include "libnode/uv/error.h"
@@ -30,7 +31,7 @@ class Handle {
         unref_ = true;
     }
 
-    void close() {
+    virtual void close() {
         if (handle_) {
             uv_close(handle_, onClose);
             handle_ = NULL;
@@ -54,6 +55,50 @@ class Handle {
         Error::setLast(uv_last_error(uv_default_loop()).code);
     }
 
+    // for system calls made outside of libuv
+    static void setLastError(int sysErrno) {
+        uv_err_code code;
+        switch (sysErrno) {
+        case EINVAL:
+            code = UV_EINVAL;
+            break;
+        case EBADF:
+            code = UV_EBADF;
+            break;
+        case ENOBUFS:
+            code = UV_ENOBUFS;
+            break;
+        case ENOMEM:
+            code = UV_ENOMEM;
+            break;
+        case EPERM:
+            code = UV_EPERM;
+            break;
+        case EACCES:
+            code = UV_EACCES;
+            break;
+        case EPIPE:
+            code = UV_EPIPE;
+            break;
+        case ECONNRESET:
+            code = UV_ECONNRESET;
+            break;
+        case EIO:
+            code = UV_EIO;
+            break;
+        case ENOTSUP:
+#if defined(EOPNOTSUPP) && EOPNOTSUPP != ENOTSUP
+        case EOPNOTSUPP:
+#endif
+        case ENOPROTOOPT:
+            code = UV_ENOTSUP;
+            break;
+        default:
+            code = UV_UNKNOWN;
+        }
+        Error::setLast(code);
+    }
+
  private:
     static void onClose(uv_handle_t* handle) {
         Handle* self = static_cast<Handle*>(handle->data);
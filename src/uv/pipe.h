@@ -3,6 +3,15 @@
 #ifndef LIBNODE_SRC_UV_PIPE_H_
 #define LIBNODE_SRC_UV_PIPE_H_
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #include "./stream.h"
 
 namespace libj {
@@ -14,7 +23,8 @@ class Pipe : public Stream {
     uv_pipe_t* uvPipe() { return &pipe_; }
 
     Pipe(Boolean ipc = false)
-        : Stream(reinterpret_cast<uv_stream_t*>(&pipe_)) {
+        : Stream(reinterpret_cast<uv_stream_t*>(&pipe_))
+        , name_(String::null()) {
         Int r = uv_pipe_init(uv_default_loop(), &pipe_, ipc);
         assert(r == 0);
         pipe_.data = this;
@@ -22,8 +32,82 @@ class Pipe : public Stream {
 
     Int bind(String::CPtr name) {
         Int r = uv_pipe_bind(&pipe_, name->toStdString().c_str());
-        if (r) setLastError();
+        if (r) {
+            setLastError();
+        } else {
+            name_ = name;
+        }
+        return r;
+    }
+
+    // change the permissions of the bound socket file
+    Int setMode(Int mode) {
+#ifdef _WIN32
+        Error::setLast(UV_ENOTSUP);
+        return -1;
+#else
+        if (!name_) {
+            Error::setLast(UV_EINVAL);
+            return -1;
+        }
+
+        Int r = ::chmod(name_->toStdString().c_str(), mode);
+        if (r) setLastError(errno);
         return r;
+#endif
+    }
+
+    // unlink 'name' if it is a socket file nobody is listening on,
+    // which is left behind when a server process dies without closing
+    static Int removeStale(String::CPtr name) {
+#ifdef _WIN32
+        return 0;
+#else
+        assert(name);
+        std::string path = name->toStdString();
+
+        struct stat st;
+        if (::lstat(path.c_str(), &st)) return 0;
+        if (!S_ISSOCK(st.st_mode)) {
+            Error::setLast(UV_EADDRINUSE);
+            return -1;
+        }
+
+        struct sockaddr_un addr;
+        if (path.length() >= sizeof(addr.sun_path)) {
+            Error::setLast(UV_ENAMETOOLONG);
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.length());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            setLastError(errno);
+            return -1;
+        }
+
+        // non-blocking, so a listener with a full backlog counts as alive
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        Int r = ::connect(
+            fd,
+            reinterpret_cast<struct sockaddr*>(&addr),
+            sizeof(addr));
+        int err = r ? errno : 0;
+        ::close(fd);
+
+        if (err == ECONNREFUSED) {
+            if (::unlink(path.c_str()) && errno != ENOENT) {
+                setLastError(errno);
+                return -1;
+            }
+            return 0;
+        } else {
+            Error::setLast(UV_EADDRINUSE);
+            return -1;
+        }
+#endif
     }
 
     Int listen(Int backlog) {
@@ -51,24 +135,14 @@ class Pipe : public Stream {
         return creq;
     }
 
- private:
-    static void onConnection(uv_stream_t* handle, int status) {
-        Pipe* self = static_cast<Pipe*>(handle->data);
-        assert(self && self->stream_ == handle);
-
-        if (status) {
-            setLastError();
-            self->onConnection_->call();
-            return;
-        } else {
-            Pipe* pipe = new Pipe(false);
-            if (uv_accept(handle, pipe->stream_)) return;
-            self->onConnection_->call(pipe);
-        }
+ protected:
+    Stream* createClient() {
+        return new Pipe(false);
     }
 
  private:
     uv_pipe_t pipe_;
+    String::CPtr name_;
 };
 
 }  // namespace uv
@@ -0,0 +1,74 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_UV_POLL_H_
+#define LIBNODE_SRC_UV_POLL_H_
+
+#include <libj/js_function.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "./handle.h"
+
+namespace libj {
+namespace node {
+namespace uv {
+
+class Poll : public Handle {
+ public:
+    uv_poll_t* uvPoll() { return &poll_; }
+
+    // if 'ownsFd', 'fd' is closed after the handle is closed,
+    // when the event loop no longer watches it
+    Poll(int fd, Boolean ownsFd = false)
+        : Handle(reinterpret_cast<uv_handle_t*>(&poll_))
+        , fd_(fd)
+        , ownsFd_(ownsFd)
+        , onPoll_(JsFunction::null()) {
+        Int r = uv_poll_init(uv_default_loop(), &poll_, fd);
+        assert(r == 0);
+        poll_.data = this;
+    }
+
+    virtual ~Poll() {
+#ifndef _WIN32
+        if (ownsFd_) ::close(fd_);
+#endif
+    }
+
+    Int start(Int events) {
+        Int r = uv_poll_start(&poll_, events, onPoll);
+        if (r) setLastError();
+        return r;
+    }
+
+    Int stop() {
+        Int r = uv_poll_stop(&poll_);
+        if (r) setLastError();
+        return r;
+    }
+
+    void setOnPoll(JsFunction::Ptr callback) {
+        onPoll_ = callback;
+    }
+
+ private:
+    static void onPoll(uv_poll_t* handle, int status, int events) {
+        Poll* self = static_cast<Poll*>(handle->data);
+        if (status) setLastError();
+        if (self->onPoll_) self->onPoll_->call(status, events);
+    }
+
+ private:
+    uv_poll_t poll_;
+    int fd_;
+    Boolean ownsFd_;
+    JsFunction::Ptr onPoll_;
+};
+
+}  // namespace uv
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_UV_POLL_H_
@@ -0,0 +1,38 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_SRC_UV_SEND_FILE_H_
+#define LIBNODE_SRC_UV_SEND_FILE_H_
+
+#include <libj/js_function.h>
+
+namespace libj {
+namespace node {
+namespace uv {
+
+class SendFile {
+ public:
+    SendFile(int fd, Size offset, Size length)
+        : fd(fd)
+        , offset(offset)
+        , length(length)
+        , bytes(0)
+        , onComplete(JsFunction::null())
+        , cb(JsFunction::null()) {}
+
+    Boolean finished() const {
+        return bytes >= length;
+    }
+
+    int fd;
+    Size offset;
+    Size length;
+    Size bytes;
+    JsFunction::Ptr onComplete;
+    JsFunction::Ptr cb;
+};
+
+}  // namespace uv
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_SRC_UV_SEND_FILE_H_
@@ -1,6 +1,16 @@
 
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <errno.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
 #include "./pipe.h"
 #include "./tcp.h"
 
@@ -43,6 +53,137 @@ void Stream::onReadCommon(
     if (onRead) onRead->call(stream->buffer_, pendingObj);
 }
 
+void Stream::onConnection(uv_stream_t* handle, int status) {
+    Stream* self = static_cast<Stream*>(handle->data);
+    assert(self && self->stream_ == handle);
+
+    if (status) {
+        setLastError();
+        self->onConnection_->call();
+        return;
+    }
+
+    // leave the rest of the backlog to the next loop iteration.
+    // libuv stops polling the listen socket until uv_accept is called.
+    if (self->acceptBatch_ > 1 &&
+        self->acceptsInWakeup_ >= self->acceptBatch_) {
+        self->acceptDeferred_ = true;
+        return;
+    }
+
+    Stream* client = self->createClient();
+    if (uv_accept(handle, client->stream_)) {
+        setLastError();
+        client->close();
+        return;
+    }
+
+    if (!self->acceptsInWakeup_) self->startAcceptCheck();
+    self->acceptsInWakeup_++;
+    self->accepts_++;
+
+    if (self->acceptBatch_ > 1) {
+        if (!self->acceptedClients_)
+            self->acceptedClients_ = JsArray::create();
+        self->acceptedClients_->add(client);
+    } else {
+        self->onConnection_->call(client);
+    }
+}
+
+SendFile* Stream::sendFile(int fd, Size offset, Size length) {
+    assert(!sendFile_);
+
+#ifdef _WIN32
+    Error::setLast(UV_ENOTSUP);
+    return NULL;
+#else
+    // libuv already watches the socket itself, so wait for it to become
+    // writable through a duplicate descriptor, which is kept for reuse
+    // and closed by the poll handle once it is closed
+    if (!poll_) {
+        int sock = this->fd();
+        int pollFd = sock < 0 ? -1 : ::dup(sock);
+        if (pollFd < 0) {
+            setLastError(sock < 0 ? EBADF : errno);
+            return NULL;
+        }
+        poll_ = new Poll(pollFd, true);
+        poll_->setOnPoll(JsFunction::Ptr(new OnWritable(this)));
+    }
+
+    // completion is always reported asynchronously from the poll,
+    // even when the whole region was sent right away
+    SendFile* req = new SendFile(fd, offset, length);
+    if (transferFile(req) || poll_->start(UV_WRITABLE)) {
+        delete req;
+        return NULL;
+    }
+    sendFile_ = req;
+    return req;
+#endif
+}
+
+Int Stream::transferFile(SendFile* req) {
+#ifdef _WIN32
+    Error::setLast(UV_ENOTSUP);
+    return -1;
+#else
+    int sock = fd();
+    while (!req->finished()) {
+        Size rest = req->length - req->bytes;
+        Size offset = req->offset + req->bytes;
+        ssize_t n;
+#if defined(__linux__)
+        off_t off = offset;
+        n = ::sendfile(sock, req->fd, &off, rest);
+#elif defined(__APPLE__)
+        off_t len = rest;
+        n = ::sendfile(req->fd, sock, offset, &len, NULL, 0);
+        if (len > 0) {
+            // partial writes are reported with EAGAIN
+            req->bytes += len;
+            continue;
+        }
+#else
+        char buf[64 * 1024];
+        n = ::pread(req->fd, buf, rest < sizeof(buf) ? rest : sizeof(buf),
+                    offset);
+        if (n > 0) n = ::write(sock, buf, n);
+#endif
+        if (n > 0) {
+            req->bytes += n;
+        } else if (!n) {
+            // the file is shorter than requested
+            Error::setLast(UV_EOF);
+            return -1;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else if (errno != EINTR) {
+            setLastError(errno);
+            return -1;
+        }
+    }
+    return 0;
+#endif
+}
+
+void Stream::afterWritable(int status) {
+    SendFile* req = sendFile_;
+    if (!req) {
+        poll_->stop();
+        return;
+    }
+
+    if (!status && transferFile(req)) status = -1;
+    if (!status && !req->finished()) return;
+
+    poll_->stop();
+    sendFile_ = NULL;
+    req->onComplete->call(status, this, req);
+    delete req;
+}
+
 }  // namespace uv
 }  // namespace node
 }  // namespace libj
@@ -3,7 +3,18 @@
 #ifndef LIBNODE_SRC_UV_STREAM_H_
 #define LIBNODE_SRC_UV_STREAM_H_
 
+#include <libj/js_array.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <vector>
+
+#include "./check.h"
 #include "./handle.h"
+#include "./poll.h"
+#include "./send_file.h"
 #include "./write.h"
 
 namespace libj {
@@ -17,6 +28,20 @@ class Stream : public Handle {
  public:
     uv_stream_t* uvStream() const { return stream_; }
 
+    // -1 until the socket has been created (by bind, connect or accept)
+    int fd() const {
+#ifdef _WIN32
+        return -1;
+#else
+        return stream_->io_watcher.fd;
+#endif
+    }
+
+    // bytes written but not yet accepted by the kernel
+    Size writeQueueSize() const {
+        return stream_->write_queue_size;
+    }
+
     virtual Int listen(Int backlog) = 0;
 
     void setOnRead(JsFunction::Ptr callback) {
@@ -27,6 +52,41 @@ class Stream : public Handle {
         onConnection_ = callback;
     }
 
+    // accept up to 'batch' connections per loop iteration and hand them
+    // to the connection callback as a single JsArray (1: no batching)
+    void setAcceptBatch(Size batch) {
+        acceptBatch_ = batch ? batch : 1;
+    }
+
+    Size acceptBatch() const { return acceptBatch_; }
+    Size accepts() const { return accepts_; }
+    Size acceptWakeups() const { return acceptWakeups_; }
+    Size lastAcceptsPerWakeup() const { return lastAcceptsPerWakeup_; }
+    Size maxAcceptsPerWakeup() const { return maxAcceptsPerWakeup_; }
+
+    virtual void close() {
+        if (check_) {
+            check_->close();
+            check_ = NULL;
+        }
+        if (poll_) {
+            poll_->close();
+            poll_ = NULL;
+        }
+        delete sendFile_;
+        sendFile_ = NULL;
+        if (acceptedClients_) {
+            Size len = acceptedClients_->length();
+            for (Size i = 0; i < len; i++) {
+                Stream* client = NULL;
+                to<Stream*>(acceptedClients_->get(i), &client);
+                if (client) client->close();
+            }
+            acceptedClients_ = JsArray::null();
+        }
+        Handle::close();
+    }
+
     virtual void setHandle(uv_handle_t* handle) {
         Handle::setHandle(handle);
         stream_ = reinterpret_cast<uv_stream_t*>(handle);
@@ -81,6 +141,41 @@ class Stream : public Handle {
         }
     }
 
+    // one write of all the Buffers in 'bufs', in order
+    Write* writeBuffers(JsArray::CPtr bufs) {
+        Size num = bufs->length();
+        std::vector<uv_buf_t> uvBufs(num);
+        Size length = 0;
+        for (Size i = 0; i < num; i++) {
+            Buffer::CPtr buf = bufs->getCPtr<Buffer>(i);
+            assert(buf);
+            uvBufs[i].base =
+                static_cast<char*>(const_cast<void*>(buf->data()));
+            uvBufs[i].len = buf->length();
+            length += buf->length();
+        }
+
+        Write* req = new Write();
+        req->buffers = bufs;
+        Int r = uv_write(
+                    &req->req,
+                    stream_,
+                    &uvBufs[0],
+                    num,
+                    afterWrite);
+
+        req->dispatched();
+        req->bytes = length;
+
+        if (r) {
+            setLastError();
+            delete req;
+            return NULL;
+        } else {
+            return req;
+        }
+    }
+
     Write* writeString(
         String::CPtr str,
         Buffer::Encoding enc,
@@ -128,6 +223,10 @@ class Stream : public Handle {
         }
     }
 
+    // send 'length' bytes of 'fd' from 'offset' without copying them
+    // to user space. nothing else may be written until it completes.
+    SendFile* sendFile(int fd, Size offset, Size length);
+
     Shutdown* shutdown() {
         Shutdown* req = new Shutdown();
         Int r = uv_shutdown(&req->req, stream_, afterShutdown);
@@ -193,7 +292,78 @@ class Stream : public Handle {
         delete sreq;
     }
 
+ private:
+    class OnAcceptCheck : LIBJ_JS_FUNCTION(OnAcceptCheck)
+     public:
+        OnAcceptCheck(Stream* stream) : self_(stream) {}
+
+        Value operator()(JsArray::Ptr args) {
+            self_->afterAccepts();
+            return libj::Status::OK;
+        }
+
+     private:
+        Stream* self_;
+    };
+
+    class OnWritable : LIBJ_JS_FUNCTION(OnWritable)
+     public:
+        OnWritable(Stream* stream) : self_(stream) {}
+
+        Value operator()(JsArray::Ptr args) {
+            int status = 0;
+            to<int>(args->get(0), &status);
+            self_->afterWritable(status);
+            return Status::OK;
+        }
+
+     private:
+        Stream* self_;
+    };
+
+    Int transferFile(SendFile* req);
+
+    void afterWritable(int status);
+
+    void startAcceptCheck() {
+        if (!check_) {
+            check_ = new Check();
+            check_->setOnCheck(JsFunction::Ptr(new OnAcceptCheck(this)));
+            check_->unref();
+        }
+        check_->start();
+    }
+
+    // runs once per loop iteration in which connections were accepted
+    void afterAccepts() {
+        acceptWakeups_++;
+        lastAcceptsPerWakeup_ = acceptsInWakeup_;
+        if (maxAcceptsPerWakeup_ < acceptsInWakeup_)
+            maxAcceptsPerWakeup_ = acceptsInWakeup_;
+        acceptsInWakeup_ = 0;
+
+        if (acceptedClients_ && !acceptedClients_->isEmpty()) {
+            JsArray::Ptr clients = acceptedClients_;
+            acceptedClients_ = JsArray::create();
+            onConnection_->call(clients);
+        }
+
+        if (!handle_) return;
+
+        if (acceptDeferred_) {
+            acceptDeferred_ = false;
+            onConnection(stream_, 0);
+        } else if (check_) {
+            check_->stop();
+        }
+    }
+
  protected:
+    virtual Stream* createClient() = 0;
+
+    // for Pipe and Tcp
+    static void onConnection(uv_stream_t* handle, int status);
+
     // for Pipe and Tcp
     static void afterConnect(uv_connect_t* req, int status) {
         Connect* creq = static_cast<Connect*>(req->data);
@@ -218,13 +388,35 @@ class Stream : public Handle {
     Buffer::Ptr buffer_;
     JsFunction::Ptr onRead_;
     JsFunction::Ptr onConnection_;
+    Size acceptBatch_;
+    Size acceptsInWakeup_;
+    Size accepts_;
+    Size acceptWakeups_;
+    Size lastAcceptsPerWakeup_;
+    Size maxAcceptsPerWakeup_;
+    Boolean acceptDeferred_;
+    JsArray::Ptr acceptedClients_;
+    Check* check_;
+    SendFile* sendFile_;
+    Poll* poll_;
 
     Stream(uv_stream_t* stream)
         : Handle(reinterpret_cast<uv_handle_t*>(stream))
         , stream_(stream)
         , buffer_(Buffer::null())
         , onRead_(JsFunction::null())
-        , onConnection_(JsFunction::null()) {
+        , onConnection_(JsFunction::null())
+        , acceptBatch_(1)
+        , acceptsInWakeup_(0)
+        , accepts_(0)
+        , acceptWakeups_(0)
+        , lastAcceptsPerWakeup_(0)
+        , maxAcceptsPerWakeup_(0)
+        , acceptDeferred_(false)
+        , acceptedClients_(JsArray::null())
+        , check_(NULL)
+        , sendFile_(NULL)
+        , poll_(NULL) {
         assert(stream_);
         stream_->data = this;
     }
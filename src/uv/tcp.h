@@ -5,6 +5,12 @@
 
 #include <libj/symbol.h>
 
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 #include "./stream.h"
 
 namespace libj {
@@ -63,6 +69,68 @@ class Tcp : public Stream {
         return r;
     }
 
+    // the following socket options need the underlying socket,
+    // so call them after bind() or connect()
+
+    Int setSendBufferSize(Int size) {
+#ifdef SO_SNDBUF
+        return setSockOpt(SOL_SOCKET, SO_SNDBUF, size);
+#else
+        return notSupported();
+#endif
+    }
+
+    Int setReceiveBufferSize(Int size) {
+#ifdef SO_RCVBUF
+        return setSockOpt(SOL_SOCKET, SO_RCVBUF, size);
+#else
+        return notSupported();
+#endif
+    }
+
+    // wake up the listener only when data arrives (in seconds)
+    Int setDeferAccept(Int timeout) {
+#ifdef TCP_DEFER_ACCEPT
+        return setSockOpt(IPPROTO_TCP, TCP_DEFER_ACCEPT, timeout);
+#else
+        return notSupported();
+#endif
+    }
+
+    // must be called before listen()
+    Int setFastOpen(Int queueLength) {
+#ifdef TCP_FASTOPEN
+        return setSockOpt(IPPROTO_TCP, TCP_FASTOPEN, queueLength);
+#else
+        return notSupported();
+#endif
+    }
+
+    // must be called before connect()
+    Int setFastOpenConnect(Boolean enable) {
+#ifdef TCP_FASTOPEN_CONNECT
+        return setSockOpt(IPPROTO_TCP, TCP_FASTOPEN_CONNECT, enable ? 1 : 0);
+#else
+        return notSupported();
+#endif
+    }
+
+    Int setQuickAck(Boolean enable) {
+#ifdef TCP_QUICKACK
+        return setSockOpt(IPPROTO_TCP, TCP_QUICKACK, enable ? 1 : 0);
+#else
+        return notSupported();
+#endif
+    }
+
+    Int setNotSentLowat(Int bytes) {
+#ifdef TCP_NOTSENT_LOWAT
+        return setSockOpt(IPPROTO_TCP, TCP_NOTSENT_LOWAT, bytes);
+#else
+        return notSupported();
+#endif
+    }
+
     Int bind(String::CPtr ip, Int port = 0) {
         struct sockaddr_in address =
             uv_ip4_addr(ip->toStdString().c_str(), port);
@@ -123,6 +191,27 @@ class Tcp : public Stream {
     }
 
  private:
+    Int setSockOpt(int level, int name, int value) {
+#ifdef _WIN32
+        return notSupported();
+#else
+        int fd = this->fd();
+        if (fd < 0) {
+            setLastError(EBADF);
+            return -1;
+        }
+
+        Int r = setsockopt(fd, level, name, &value, sizeof(value));
+        if (r) setLastError(errno);
+        return r;
+#endif
+    }
+
+    static Int notSupported() {
+        Error::setLast(UV_ENOTSUP);
+        return -1;
+    }
+
     JsObject::Ptr addressToJs(const sockaddr* addr) {
         LIBJ_STATIC_SYMBOL_DEF(symIpV4,    "IPv4");
         LIBJ_STATIC_SYMBOL_DEF(symIpV6,    "IPv6");
@@ -157,20 +246,9 @@ class Tcp : public Stream {
         return res;
     }
 
- private:
-    static void onConnection(uv_stream_t* handle, int status) {
-        Tcp* self = static_cast<Tcp*>(handle->data);
-        assert(self && self->stream_ == handle);
-
-        if (status) {
-            setLastError();
-            self->onConnection_->call();
-            return;
-        } else {
-            Tcp* tcp = new Tcp();
-            if (uv_accept(handle, tcp->stream_)) return;
-            self->onConnection_->call(tcp);
-        }
+ protected:
+    Stream* createClient() {
+        return new Tcp();
     }
 
  private:
@@ -3,6 +3,8 @@
 #ifndef LIBNODE_SRC_UV_WRITE_H_
 #define LIBNODE_SRC_UV_WRITE_H_
 
+#include <libj/js_array.h>
+
 #include "libnode/buffer.h"
 
 #include "./req.h"
@@ -15,10 +17,12 @@ class Write : public Req<uv_write_t> {
  public:
     Write()
         : buffer(Buffer::null())
+        , buffers(JsArray::null())
         , cb(JsFunction::null()) {}
 
     Size bytes;
     Buffer::CPtr buffer;
+    JsArray::CPtr buffers;
     JsFunction::Ptr cb;
 };
 